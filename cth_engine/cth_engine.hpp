@@ -1,3 +1,4 @@
 #pragma once
+#include "include/cth_core.hpp"
 #include "include/cth_interface.hpp"
 #include "include/cth_vulkan.hpp"
@@ -0,0 +1,3 @@
+#pragma once
+#include "core/CthCpuProfiler.hpp"
+#include "core/CthJobSystem.hpp"
\ No newline at end of file
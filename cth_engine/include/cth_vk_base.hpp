@@ -1,3 +1,6 @@
 #pragma once
+#include "vulkan/base/CthCommandAllocator.hpp"
+#include "vulkan/base/CthDeletionQueue.hpp"
 #include "vulkan/base/CthDevice.hpp"
-#include "vulkan/base/CthInstance.hpp"
\ No newline at end of file
+#include "vulkan/base/CthInstance.hpp"
+#include "vulkan/base/CthTimeline.hpp"
\ No newline at end of file
@@ -1,2 +1,4 @@
 #pragma once
-#include "vulkan/debug/CthDebugMessenger.hpp"
\ No newline at end of file
+#include "vulkan/debug/CthDebugMessenger.hpp"
+#include "vulkan/debug/CthGpuProfiler.hpp"
+#include "vulkan/debug/CthResourceTracker.hpp"
\ No newline at end of file
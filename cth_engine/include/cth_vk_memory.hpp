@@ -1,9 +1,20 @@
 #pragma once
+#include "vulkan/memory/allocator/CthHostAllocator.hpp"
+#include "vulkan/memory/allocator/CthMemoryAllocator.hpp"
+#include "vulkan/memory/allocator/CthMemoryStats.hpp"
+
+
 #include "vulkan/memory/buffer/CthBuffer.hpp"
 #include "vulkan/memory/buffer/CthDefaultBuffer.hpp"
+#include "vulkan/memory/buffer/CthFrameAllocator.hpp"
+#include "vulkan/memory/buffer/CthGrowableBuffer.hpp"
+#include "vulkan/memory/buffer/CthStagingRing.hpp"
 
 
 #include "vulkan/memory/descriptor/CthDescriptedResource.hpp"
 #include "vulkan/memory/descriptor/CthDescriptor.hpp"
 #include "vulkan/memory/descriptor/CthDescriptorPool.hpp"
-#include "vulkan/memory/descriptor/CthDescriptorSet.hpp"
\ No newline at end of file
+#include "vulkan/memory/descriptor/CthDescriptorSet.hpp"
+
+
+#include "vulkan/memory/transfer/CthUploadQueue.hpp"
\ No newline at end of file
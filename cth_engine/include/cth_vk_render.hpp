@@ -7,5 +7,6 @@
 #include "vulkan/render/model/HlcVertex.hpp"
 
 
+#include "vulkan/render/pass/CthOffscreenRenderer.hpp"
 #include "vulkan/render/pass/CthRenderer.hpp"
 #include "vulkan/render/pass/cth_render_pass_utils.hpp"
\ No newline at end of file
@@ -0,0 +1,233 @@
+#include "CthCpuProfiler.hpp"
+
+#include <cth/cth_log.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <format>
+#include <memory>
+#include <mutex>
+
+
+
+namespace cth {
+namespace {
+    using Node = CpuProfiler::Node;
+    using Frame = CpuProfiler::Frame;
+
+    struct Marker {
+        string_view name; /*empty -> end marker*/
+        chrono::steady_clock::rep ticks;
+    };
+    /**
+     * \brief ring slot, read by the collector while the owner may overwrite it
+     */
+    struct Slot {
+        atomic<const char*> name{nullptr};
+        atomic<size_t> size{0};
+        atomic<chrono::steady_clock::rep> ticks{0};
+    };
+    struct OpenZone {
+        string_view name;
+        chrono::steady_clock::rep start;
+        uint32_t node; /*in the frame that is being collected*/
+    };
+
+    /**
+     * \brief single producer ring, only the owning thread writes, only nextFrame() reads
+     * \note slots are atomics, overwritten slots are detected by comparing started with the collected range
+     */
+    struct ThreadBuffer {
+        array<Slot, CpuProfiler::RING_SIZE> markers{};
+        atomic<uint64_t> started{0}; /*markers the owner started to write*/
+        atomic<uint64_t> head{0}; /*markers written*/
+        atomic<bool> exited{false}; /*the owner exited, the next registered thread takes over the ring*/
+
+        uint32_t thread = 0;
+        uint64_t tail = 0; /*markers collected*/
+        vector<OpenZone> open{}; /*zones without end marker at the last collection*/
+    };
+
+    mutex registryMutex{};
+    vector<shared_ptr<ThreadBuffer>> buffers{}; /*[thread]*/
+
+    mutex frameMutex{};
+    Frame finishedFrame{};
+    chrono::steady_clock::time_point frameStart = chrono::steady_clock::now();
+
+
+    shared_ptr<ThreadBuffer> registerThread() {
+        lock_guard lock{registryMutex};
+
+        //the ring continues where the exited owner stopped, the collector does not notice the handover
+        const auto reusable = ranges::find_if(buffers, [](const shared_ptr<ThreadBuffer>& buffer) {
+            return buffer->exited.load(memory_order_acquire);
+        });
+        if(reusable != buffers.end()) {
+            (*reusable)->exited.store(false, memory_order_relaxed);
+            return *reusable;
+        }
+
+        const auto buffer = make_shared<ThreadBuffer>();
+        buffer->thread = static_cast<uint32_t>(buffers.size());
+        buffers.push_back(buffer);
+        return buffer;
+    }
+    /**
+     * \brief releases the ring of the thread on exit
+     */
+    struct ThreadOwner {
+        shared_ptr<ThreadBuffer> buffer = registerThread();
+        ~ThreadOwner() { buffer->exited.store(true, memory_order_release); }
+    };
+    ThreadBuffer& threadBuffer() {
+        thread_local const ThreadOwner owner{};
+        return *owner.buffer;
+    }
+    void push(const Marker& marker) {
+        ThreadBuffer& buffer = threadBuffer();
+        const uint64_t head = buffer.head.load(memory_order_relaxed);
+        Slot& slot = buffer.markers[head % CpuProfiler::RING_SIZE];
+
+        //seqlock, a collector reading the new slot values also sees started
+        buffer.started.store(head + 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+        slot.name.store(marker.name.data(), memory_order_relaxed);
+        slot.size.store(marker.name.size(), memory_order_relaxed);
+        slot.ticks.store(marker.ticks, memory_order_relaxed);
+
+        buffer.head.store(head + 1, memory_order_release);
+    }
+
+    double toMs(const chrono::steady_clock::rep ticks) {
+        return chrono::duration<double, milli>(chrono::steady_clock::duration{ticks}).count();
+    }
+
+    uint32_t child(Frame& frame, const uint32_t parent, const uint32_t thread, const string_view name) {
+        for(uint32_t i = parent == CpuProfiler::INVALID_NODE ? 0 : parent + 1; i < frame.nodes.size(); i++) {
+            const Node& node = frame.nodes[i];
+            if(node.parent == parent && node.thread == thread && node.name == name) return i;
+        }
+
+        const uint32_t depth = parent == CpuProfiler::INVALID_NODE ? 0 : frame.nodes[parent].depth + 1;
+        frame.nodes.push_back(Node{name, parent, depth, thread});
+        return static_cast<uint32_t>(frame.nodes.size() - 1);
+    }
+
+    /**
+     * \brief moves the new markers of buffer into the tree of frame
+     */
+    void collect(Frame& frame, ThreadBuffer& buffer) {
+        const uint64_t head = buffer.head.load(memory_order_acquire);
+        if(head == buffer.tail) return;
+
+        vector<Marker> markers{};
+        if(head - buffer.tail <= CpuProfiler::RING_SIZE) {
+            markers.reserve(head - buffer.tail);
+            for(uint64_t i = buffer.tail; i < head; i++) {
+                const Slot& slot = buffer.markers[i % CpuProfiler::RING_SIZE];
+                const char* name = slot.name.load(memory_order_relaxed);
+                const size_t size = slot.size.load(memory_order_relaxed);
+                markers.emplace_back(string_view{name, size}, slot.ticks.load(memory_order_relaxed));
+            }
+        }
+
+        //the owner may have started to overwrite the ring while it was copied, the copied slots may be torn
+        atomic_thread_fence(memory_order_acquire);
+        const bool overflow = buffer.started.load(memory_order_relaxed) - buffer.tail > CpuProfiler::RING_SIZE;
+        buffer.tail = head;
+
+        CTH_WARN(overflow, "cpu profiler ring overflow, markers of the frame dropped") {
+            details->add("thread: {}", buffer.thread);
+            buffer.open.clear();
+            return;
+        }
+
+        //zones spanning the frame boundary are moved into the new tree
+        for(size_t i = 0; i < buffer.open.size(); i++)
+            buffer.open[i].node = child(frame, i == 0 ? CpuProfiler::INVALID_NODE : buffer.open[i - 1].node, buffer.thread, buffer.open[i].name);
+
+        for(const Marker& marker : markers) {
+            if(!marker.name.empty()) {
+                const uint32_t parent = buffer.open.empty() ? CpuProfiler::INVALID_NODE : buffer.open.back().node;
+                buffer.open.emplace_back(marker.name, marker.ticks, child(frame, parent, buffer.thread, marker.name));
+                continue;
+            }
+
+            //the begin marker was dropped
+            if(buffer.open.empty()) continue;
+
+            const OpenZone zone = buffer.open.back();
+            buffer.open.pop_back();
+
+            Node& node = frame.nodes[zone.node];
+            node.ms += toMs(marker.ticks - zone.start);
+            node.calls++;
+        }
+    }
+
+    void appendNode(string& result, const Frame& frame, const uint32_t index) {
+        const Node& node = frame.nodes[index];
+        result += format("{0:\t>{1}}{2}: {3:.3f} ms, {4} calls\n", "", node.depth + 2, node.name, node.ms, node.calls);
+
+        for(uint32_t i = index + 1; i < frame.nodes.size(); i++)
+            if(frame.nodes[i].parent == index) appendNode(result, frame, i);
+    }
+} // namespace
+
+
+void CpuProfiler::begin(const string_view name) { push(Marker{name, chrono::steady_clock::now().time_since_epoch().count()}); }
+void CpuProfiler::end() { push(Marker{{}, chrono::steady_clock::now().time_since_epoch().count()}); }
+
+void CpuProfiler::nextFrame() {
+    const auto now = chrono::steady_clock::now();
+
+    vector<shared_ptr<ThreadBuffer>> threads{};
+    {
+        lock_guard lock{registryMutex};
+        threads = buffers;
+    }
+
+    lock_guard lock{frameMutex};
+    Frame frame{chrono::duration<double, milli>(now - frameStart).count()};
+    frameStart = now;
+
+    for(const auto& buffer : threads) collect(frame, *buffer);
+
+    finishedFrame = std::move(frame);
+}
+
+CpuProfiler::Frame CpuProfiler::lastFrame() {
+    lock_guard lock{frameMutex};
+    return finishedFrame;
+}
+double CpuProfiler::zoneMs(const string_view name) {
+    lock_guard lock{frameMutex};
+
+    double ms = 0;
+    for(const Node& node : finishedFrame.nodes)
+        if(node.name == name) ms += node.ms;
+    return ms;
+}
+string CpuProfiler::report() {
+    const Frame frame = lastFrame();
+    string result = format("cpu frame: {:.3f} ms\n", frame.ms);
+
+    uint32_t thread = INVALID_NODE;
+    for(uint32_t i = 0; i < frame.nodes.size(); i++) {
+        if(frame.nodes[i].parent != INVALID_NODE) continue;
+
+        if(frame.nodes[i].thread != thread) {
+            thread = frame.nodes[i].thread;
+            result += format("\tthread {}\n", thread);
+        }
+        appendNode(result, frame, i);
+    }
+
+    return result;
+}
+void CpuProfiler::logReport() { cth::log::msg<except::INFO>("{}", report()); }
+
+} // namespace cth
@@ -0,0 +1,88 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace cth {
+using namespace std;
+
+/**
+ * \brief hierarchical cpu zones, every thread writes begin and end markers into its own ring buffer
+ * \note nextFrame() collects the markers of all threads and aggregates them into a tree for the frame
+ * \note a long fence wait zone means the frame waited for the gpu, a long record zone means the cpu is the bottleneck
+ * \note writing markers takes no lock, only the first marker of a thread locks to register it
+ * \note the other functions are thread safe, rings of exited threads are reused by new threads
+ */
+class CpuProfiler {
+public:
+    static constexpr uint32_t INVALID_NODE = ~0u;
+
+    struct Node {
+        string_view name;
+        uint32_t parent; /*INVALID_NODE for top level zones*/
+        uint32_t depth;
+        uint32_t thread; /*in order of the first zone of the thread, reused after the thread exited*/
+        double ms = 0; /*summed duration in milliseconds*/
+        uint32_t calls = 0;
+    };
+    struct Frame {
+        double ms = 0; /*wall time between the frame boundaries in milliseconds*/
+        vector<Node> nodes{}; /*parents precede their children*/
+    };
+
+    /**
+     * \brief measures its lifetime on the calling thread
+     */
+    class Zone {
+    public:
+        /**
+         * \param name must outlive the profiler, usually a literal
+         */
+        explicit Zone(const string_view name) { CpuProfiler::begin(name); }
+        ~Zone() { CpuProfiler::end(); }
+
+        Zone(const Zone& other) = delete;
+        Zone(Zone&& other) = delete;
+        Zone& operator=(const Zone& other) = delete;
+        Zone& operator=(Zone&& other) = delete;
+    };
+
+    /**
+     * \brief opens a zone on the calling thread, prefer Zone
+     * \param name must outlive the profiler, usually a literal
+     * \note for zones spanning functions, every begin() needs an end() on the same thread
+     */
+    static void begin(string_view name);
+    /**
+     * \brief closes the innermost zone of the calling thread
+     */
+    static void end();
+
+    /**
+     * \brief closes the current frame and aggregates the markers of every thread
+     * \note zones still open are attributed to the frame they end in
+     */
+    static void nextFrame();
+
+    /**
+     * \return aggregated tree of the last finished frame
+     */
+    [[nodiscard]] static Frame lastFrame();
+    /**
+     * \return summed duration of every zone with name in the last frame, across threads
+     */
+    [[nodiscard]] static double zoneMs(string_view name);
+    /**
+     * \return indented zone tree of the last frame per thread
+     */
+    [[nodiscard]] static string report();
+    static void logReport();
+
+    static constexpr size_t RING_SIZE = 4096; /*markers per thread and frame, older markers are dropped*/
+
+    CpuProfiler() = delete;
+};
+
+} // namespace cth
@@ -0,0 +1,172 @@
+#include "CthJobSystem.hpp"
+
+#include <cth/cth_log.hpp>
+
+#include <algorithm>
+
+
+
+namespace cth {
+void JobSystem::run(function<void()> job, JobCounter* counter) {
+    if(counter != nullptr) addPending(*counter);
+    push(Job{std::move(job), counter});
+}
+void JobSystem::runAfter(JobCounter& dependency, function<void()> job, JobCounter* counter) {
+    if(counter != nullptr) addPending(*counter);
+
+    {
+        lock_guard lock{dependency.continuationMutex};
+        //the last job of dependency moves the continuations out under the same mutex after pending reached zero
+        if(dependency.pending.load(memory_order_acquire) != 0) {
+            dependency.continuations.emplace_back(std::move(job), counter);
+            return;
+        }
+    }
+
+    push(Job{std::move(job), counter});
+}
+
+void JobSystem::parallelFor(const uint32_t count, const function<void(uint32_t)>& body, const uint32_t batch_size) {
+    if(count == 0) return;
+
+    const uint32_t batches = 4 * std::max(threadCount(), 1u);
+    const uint32_t batchSize = batch_size == 0 ? std::max(count / batches, 1u) : batch_size;
+
+    JobCounter counter{};
+    for(uint32_t begin = 0; begin < count; begin += batchSize) {
+        const uint32_t end = std::min(begin + batchSize, count);
+        run([&body, begin, end] { for(uint32_t i = begin; i < end; i++) body(i); }, &counter);
+    }
+
+    wait(counter);
+}
+
+void JobSystem::wait(JobCounter& counter) {
+    Job job;
+    while(!counter.done()) {
+        if(tryPop(job)) execute(job);
+        else this_thread::yield(); //the remaining jobs are running on other threads
+    }
+
+    //no job of counter is running anymore, unwinding can't destroy state they use
+    exception_ptr exception{};
+    swap(exception, counter.exception);
+    if(exception != nullptr) rethrow_exception(exception);
+}
+
+void JobSystem::push(Job job) {
+    //workers keep their jobs local, everyone else distributes them
+    const uint32_t target = workerThread() ? currentWorker : nextWorker.fetch_add(1, memory_order_relaxed) % workers.size();
+
+    //counted first, a sleeping worker may wake before the job is visible but never misses it
+    queuedJobs.fetch_add(1, memory_order_release);
+    {
+        lock_guard lock{workers[target]->jobMutex};
+        workers[target]->jobs.push_back(std::move(job));
+    }
+
+    lock_guard lock{sleepMutex};
+    sleepCondition.notify_one();
+}
+void JobSystem::addPending(JobCounter& counter) {
+    counter.finished.store(false, memory_order_relaxed);
+    counter.pending.fetch_add(1, memory_order_acq_rel);
+}
+bool JobSystem::tryPop(Job& job) {
+    const uint32_t own = workerThread() ? currentWorker : 0;
+
+    {
+        Worker& worker = *workers[own];
+        lock_guard lock{worker.jobMutex};
+        if(!worker.jobs.empty()) {
+            job = std::move(worker.jobs.back());
+            worker.jobs.pop_back();
+            queuedJobs.fetch_sub(1, memory_order_relaxed);
+            return true;
+        }
+    }
+
+    for(size_t i = 1; i < workers.size(); i++) {
+        Worker& victim = *workers[(own + i) % workers.size()];
+        lock_guard lock{victim.jobMutex};
+        if(victim.jobs.empty()) continue;
+
+        job = std::move(victim.jobs.front());
+        victim.jobs.pop_front();
+        queuedJobs.fetch_sub(1, memory_order_relaxed);
+        return true;
+    }
+
+    return false;
+}
+void JobSystem::execute(Job& job) {
+    JobCounter* counter = job.counter;
+
+    //the counter must finish even if the job threw, the waiting thread rethrows
+    try { job.job(); }
+    catch(...) {
+        if(counter == nullptr) terminate();
+
+        lock_guard lock{counter->continuationMutex};
+        if(counter->exception == nullptr) counter->exception = current_exception();
+    }
+
+    job = {};
+    if(counter == nullptr || counter->pending.fetch_sub(1, memory_order_acq_rel) != 1) return;
+
+    vector<JobCounter::Continuation> continuations{};
+    {
+        lock_guard lock{counter->continuationMutex};
+        continuations.swap(counter->continuations);
+    }
+    //a waiting thread may destroy the counter from now on
+    counter->finished.store(true, memory_order_release);
+
+    ranges::for_each(continuations, [this](JobCounter::Continuation& continuation) {
+        push(Job{std::move(continuation.job), continuation.counter});
+    });
+}
+void JobSystem::workerLoop(const uint32_t worker_index) {
+    currentSystem = this;
+    currentWorker = worker_index;
+
+    Job job;
+    while(true) {
+        if(tryPop(job)) {
+            execute(job);
+            continue;
+        }
+
+        unique_lock lock{sleepMutex};
+        sleepCondition.wait(lock, [this] { return stopping || queuedJobs.load(memory_order_acquire) > 0; });
+        if(stopping && queuedJobs.load(memory_order_acquire) == 0) return;
+    }
+}
+
+JobSystem::JobSystem(const uint32_t thread_count) {
+    const uint32_t hardwareThreads = std::max(thread::hardware_concurrency(), 1u);
+    const uint32_t workerCount = thread_count == 0 ? hardwareThreads - 1 : thread_count;
+
+    //without workers the waiting threads run everything from a single deque
+    workers.resize(std::max(workerCount, 1u));
+    ranges::generate(workers, [] { return make_unique<Worker>(); });
+
+    threads.reserve(workerCount);
+    for(uint32_t i = 0; i < workerCount; i++) threads.emplace_back([this, i] { workerLoop(i); });
+
+    cth::log::msg<except::INFO>("job system: {} worker threads", workerCount);
+}
+JobSystem::~JobSystem() {
+    {
+        lock_guard lock{sleepMutex};
+        stopping = true;
+    }
+    sleepCondition.notify_all();
+
+    //joining the workers drains the queues, without workers the queued jobs run here
+    threads.clear();
+    Job job;
+    while(tryPop(job)) execute(job);
+}
+
+} // namespace cth
@@ -0,0 +1,145 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace cth {
+using namespace std;
+
+/**
+ * \brief counts the unfinished jobs started with it, jobs can be scheduled to start once a counter reached zero
+ * \note must outlive the jobs and continuations that reference it, may be reused once done()
+ */
+class JobCounter {
+public:
+    /**
+     * \return true once the last job finished and the counter isn't accessed by the workers anymore
+     */
+    [[nodiscard]] bool done() const { return finished.load(memory_order_acquire); }
+    [[nodiscard]] uint32_t remaining() const { return pending.load(memory_order_acquire); }
+
+private:
+    struct Continuation {
+        function<void()> job;
+        JobCounter* counter;
+    };
+
+    atomic<uint32_t> pending = 0;
+    atomic<bool> finished = true; /*set after the continuations were moved out, the last access of the finishing job*/
+    mutex continuationMutex{};
+    vector<Continuation> continuations{}; /*started once pending reaches zero*/
+    exception_ptr exception{}; /*first exception thrown by a job, guarded by continuationMutex*/
+
+    friend class JobSystem;
+
+public:
+    JobCounter() = default;
+    ~JobCounter() = default;
+
+    JobCounter(const JobCounter& other) = delete;
+    JobCounter(JobCounter&& other) = delete;
+    JobCounter& operator=(const JobCounter& other) = delete;
+    JobCounter& operator=(JobCounter&& other) = delete;
+};
+
+/**
+ * \brief work stealing thread pool for per frame cpu work
+ * \note every worker owns a deque, it pops its own jobs lifo and steals from the others fifo
+ * \note jobs started from outside the pool are distributed round robin, waiting threads help running jobs instead of blocking
+ * \note thread safe, the first exception thrown by the jobs of a counter is rethrown by wait() once the counter is done
+ * \note exceptions thrown by jobs without a counter terminate
+ */
+class JobSystem {
+public:
+    /**
+     * \brief starts job on any worker
+     * \param counter incremented now, decremented once the job finished, may be nullptr
+     */
+    void run(function<void()> job, JobCounter* counter = nullptr);
+    /**
+     * \brief starts job once dependency reached zero
+     * \param counter incremented now, decremented once the job finished, may be nullptr
+     */
+    void runAfter(JobCounter& dependency, function<void()> job, JobCounter* counter = nullptr);
+
+    /**
+     * \brief runs body for every index in [0, count) in batches across the workers and the calling thread
+     * \param batch_size indices per job, 0 -> count / (4 * workers)
+     * \note blocks until every index was processed
+     * \throws the first exception thrown by body, after every batch finished
+     */
+    void parallelFor(uint32_t count, const function<void(uint32_t)>& body, uint32_t batch_size = 0);
+
+    /**
+     * \brief runs jobs on the calling thread until counter reached zero
+     * \throws the first exception thrown by a job of counter, after every job of counter finished
+     */
+    void wait(JobCounter& counter);
+
+private:
+    struct Job {
+        function<void()> job;
+        JobCounter* counter;
+    };
+    struct Worker {
+        deque<Job> jobs{};
+        mutex jobMutex{};
+    };
+
+    void push(Job job);
+    static void addPending(JobCounter& counter);
+    /**
+     * \brief pops from the own deque of the calling worker, steals from the others otherwise
+     * \return false if every deque was empty
+     */
+    bool tryPop(Job& job);
+    /**
+     * \brief runs the job and starts the continuations of its counter if it finished last
+     */
+    void execute(Job& job);
+    void workerLoop(uint32_t worker_index);
+
+
+    vector<unique_ptr<Worker>> workers; /*one deque per worker, at least one*/
+    vector<jthread> threads;
+
+    atomic<size_t> queuedJobs = 0;
+    atomic<uint32_t> nextWorker = 0; /*round robin target for jobs started outside the pool*/
+    mutex sleepMutex{};
+    condition_variable sleepCondition{};
+    bool stopping = false;
+
+    inline static thread_local JobSystem* currentSystem = nullptr;
+    inline static thread_local uint32_t currentWorker = 0;
+
+public:
+    /**
+     * \param thread_count worker threads, 0 -> hardware concurrency - 1, the thread waiting on jobs is the last core
+     */
+    explicit JobSystem(uint32_t thread_count = 0);
+    /**
+     * \note finishes the queued jobs before joining the workers
+     */
+    ~JobSystem();
+
+    [[nodiscard]] uint32_t threadCount() const { return static_cast<uint32_t>(threads.size()); }
+    /**
+     * \return true if called from a worker of this system
+     */
+    [[nodiscard]] bool workerThread() const { return currentSystem == this; }
+
+    JobSystem(const JobSystem& other) = delete;
+    JobSystem(JobSystem&& other) = delete;
+    JobSystem& operator=(const JobSystem& other) = delete;
+    JobSystem& operator=(JobSystem&& other) = delete;
+};
+
+} // namespace cth
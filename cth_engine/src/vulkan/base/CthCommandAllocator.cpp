@@ -0,0 +1,111 @@
+#include "CthCommandAllocator.hpp"
+
+#include "CthDevice.hpp"
+
+#include "vulkan/debug/CthResourceTracker.hpp"
+#include "vulkan/memory/allocator/CthHostAllocator.hpp"
+#include "vulkan/utility/CthVkUtils.hpp"
+
+#include <cth/cth_log.hpp>
+
+#include <algorithm>
+#include <ranges>
+
+
+
+namespace cth {
+VkCommandBuffer CommandAllocator::allocate(const VkCommandBufferLevel level) {
+    Pool& pool = threadPools().frames[currentFrame];
+    auto& buffers = pool.buffers[level];
+    size_t& used = pool.used[level];
+
+    if(used < buffers.size()) return buffers[used++];
+
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.level = level;
+    allocInfo.commandPool = pool.pool;
+    allocInfo.commandBufferCount = 1;
+
+    VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+    const VkResult allocResult = vkAllocateCommandBuffers(device->get(), &allocInfo, &commandBuffer);
+    CTH_STABLE_ERR(allocResult != VK_SUCCESS, "failed to allocate command buffer")
+        throw cth::except::vk_result_exception{allocResult, details->exception()};
+
+    buffers.push_back(commandBuffer);
+    ++used;
+    return commandBuffer;
+}
+
+void CommandAllocator::reset(const uint32_t frame_index) {
+    CTH_ERR(frame_index >= frames, "frame index out of range") throw details->exception();
+
+    currentFrame = frame_index;
+
+    lock_guard lock{threadMutex};
+    for(const auto& pools : threads | views::values) {
+        Pool& pool = pools->frames[currentFrame];
+        if(ranges::all_of(pool.used, [](const size_t used) { return used == 0; })) continue;
+
+        //keeps the memory of the pool, every buffer returns to the initial state
+        const VkResult resetResult = vkResetCommandPool(device->get(), pool.pool, 0);
+        CTH_STABLE_ERR(resetResult != VK_SUCCESS, "failed to reset command pool")
+            throw cth::except::vk_result_exception{resetResult, details->exception()};
+
+        pool.used = {};
+    }
+}
+
+CommandAllocator::ThreadPools& CommandAllocator::threadPools() {
+    lock_guard lock{threadMutex};
+
+    const auto it = threads.find(this_thread::get_id());
+    if(it != threads.end()) return *it->second;
+
+    auto newPools = make_unique<ThreadPools>();
+    newPools->frames.resize(frames);
+
+    for(Pool& pool : newPools->frames) {
+        const VkResult createResult = createPool(pool.pool);
+        CTH_STABLE_ERR(createResult != VK_SUCCESS, "failed to create command pool") {
+            //the thread retries on its next allocate()
+            destroyPools(*newPools);
+            throw cth::except::vk_result_exception{createResult, details->exception()};
+        }
+    }
+
+    return *threads.emplace(this_thread::get_id(), std::move(newPools)).first->second;
+}
+VkResult CommandAllocator::createPool(VkCommandPool& pool) const {
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.queueFamilyIndex = queueFamily;
+    //buffers are only reset together with their pool
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+    const VkResult createResult = vkCreateCommandPool(device->get(), &poolInfo, HostAllocator::callbacks(HostAllocator::CATEGORY_DEVICE), &pool);
+    if constexpr(ResourceTracker::ENABLED)
+        if(createResult == VK_SUCCESS) device->resourceTracker()->add(ResourceTracker::TYPE_COMMAND_POOL, pool, 0, "CommandAllocator");
+    return createResult;
+}
+void CommandAllocator::destroyPools(const ThreadPools& pools) const {
+    //destroying a pool frees its command buffers, null pools are ignored
+    ranges::for_each(pools.frames, [this](const Pool& pool) {
+        if constexpr(ResourceTracker::ENABLED)
+            if(pool.pool != VK_NULL_HANDLE) device->resourceTracker()->remove(ResourceTracker::TYPE_COMMAND_POOL, pool.pool);
+        vkDestroyCommandPool(device->get(), pool.pool, HostAllocator::callbacks(HostAllocator::CATEGORY_DEVICE));
+    });
+}
+
+CommandAllocator::CommandAllocator(Device* device, const uint32_t queue_family_index, const uint32_t frame_count) : device(device),
+    queueFamily(queue_family_index), frames(frame_count) {}
+CommandAllocator::~CommandAllocator() {
+    for(const auto& pools : threads | views::values) destroyPools(*pools);
+}
+
+size_t CommandAllocator::threadCount() const {
+    lock_guard lock{threadMutex};
+    return threads.size();
+}
+
+} // namespace cth
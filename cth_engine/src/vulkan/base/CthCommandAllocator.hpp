@@ -0,0 +1,90 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+
+namespace cth {
+using namespace std;
+class Device;
+
+/**
+ * \brief hands out recycled command buffers from a command pool per thread and frame in flight
+ * \note a frame slot is reset as a whole with vkResetCommandPool, its command buffers are handed out again instead of freed
+ * \note allocate() is thread safe, reset() must not run concurrently to allocate() or to recording threads
+ */
+class CommandAllocator {
+public:
+    /**
+     * \brief hands out a command buffer of the calling threads pool in the current frame slot
+     * \note record it on the calling thread, the pool of a thread must not be used by others
+     * \return command buffer in the initial state, valid until the frame slot is reset
+     * \throws cth::except::vk_result_exception result of vkCreateCommandPool()
+     * \throws cth::except::vk_result_exception result of vkAllocateCommandBuffers()
+     */
+    [[nodiscard]] VkCommandBuffer allocate(VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+
+    /**
+     * \brief makes the slot of frame_index current and resets the pools of every thread in it
+     * \note the frame that last used the slot must have finished
+     * \throws cth::except::vk_result_exception result of vkResetCommandPool()
+     */
+    void reset(uint32_t frame_index);
+
+private:
+    struct Pool {
+        VkCommandPool pool = VK_NULL_HANDLE;
+        array<vector<VkCommandBuffer>, 2> buffers{}; /*[VkCommandBufferLevel]*/
+        array<size_t, 2> used{}; /*buffers handed out since the last reset per level*/
+    };
+    struct ThreadPools {
+        vector<Pool> frames{}; /*[frame_index]*/
+    };
+
+    /**
+     * \return pools of the calling thread, created on first use
+     * \throws cth::except::vk_result_exception result of vkCreateCommandPool(), the pools created until then are destroyed
+     */
+    [[nodiscard]] ThreadPools& threadPools();
+    [[nodiscard]] VkResult createPool(VkCommandPool& pool) const;
+    void destroyPools(const ThreadPools& pools) const;
+
+    Device* device;
+    uint32_t queueFamily;
+    uint32_t frames;
+    uint32_t currentFrame = 0;
+
+    unordered_map<thread::id, unique_ptr<ThreadPools>> threads{};
+    mutable mutex threadMutex{};
+
+public:
+    /**
+     * \param queue_family_index family the command buffers are submitted to
+     * \param frame_count frames in flight
+     */
+    CommandAllocator(Device* device, uint32_t queue_family_index, uint32_t frame_count);
+    /**
+     * \note the command buffers must not be pending anymore
+     */
+    ~CommandAllocator();
+
+    [[nodiscard]] uint32_t frameCount() const { return frames; }
+    [[nodiscard]] uint32_t frameIndex() const { return currentFrame; }
+    /**
+     * \return number of threads that own pools
+     */
+    [[nodiscard]] size_t threadCount() const;
+
+    CommandAllocator(const CommandAllocator& other) = delete;
+    CommandAllocator(CommandAllocator&& other) = delete;
+    CommandAllocator& operator=(const CommandAllocator& other) = delete;
+    CommandAllocator& operator=(CommandAllocator&& other) = delete;
+};
+
+} // namespace cth
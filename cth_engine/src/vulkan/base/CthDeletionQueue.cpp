@@ -0,0 +1,145 @@
+#include "CthDeletionQueue.hpp"
+
+#include "CthDevice.hpp"
+
+#include "vulkan/debug/CthResourceTracker.hpp"
+#include "vulkan/memory/allocator/CthHostAllocator.hpp"
+#include "vulkan/memory/transfer/CthUploadQueue.hpp"
+#include "vulkan/utility/CthVkUtils.hpp"
+
+#include <cth/cth_log.hpp>
+
+#include <algorithm>
+
+
+
+namespace cth {
+namespace {
+    /**
+     * \return TYPES_SIZE for handles the owner stops tracking on enqueue
+     */
+    ResourceTracker::Resource_Type trackedType(const DeletionQueue::Handle_Type type) {
+        switch(type) {
+            case DeletionQueue::TYPE_IMAGE_VIEW: return ResourceTracker::TYPE_IMAGE_VIEW;
+            case DeletionQueue::TYPE_SAMPLER: return ResourceTracker::TYPE_SAMPLER;
+            case DeletionQueue::TYPE_PIPELINE: return ResourceTracker::TYPE_PIPELINE;
+            case DeletionQueue::TYPE_DESCRIPTOR_POOL: return ResourceTracker::TYPE_DESCRIPTOR_POOL;
+            case DeletionQueue::TYPE_FRAMEBUFFER: return ResourceTracker::TYPE_FRAMEBUFFER;
+            case DeletionQueue::TYPE_RENDER_PASS: return ResourceTracker::TYPE_RENDER_PASS;
+            case DeletionQueue::TYPE_SEMAPHORE: return ResourceTracker::TYPE_SEMAPHORE;
+            case DeletionQueue::TYPE_COMMAND_POOL: return ResourceTracker::TYPE_COMMAND_POOL;
+            default: return ResourceTracker::TYPES_SIZE;
+        }
+    }
+} // namespace
+
+
+void DeletionQueue::enqueue(const MemoryAllocation& allocation) {
+    if(allocation.memory == VK_NULL_HANDLE) return;
+
+    lock_guard lock{queueMutex};
+    openBatch.allocations.push_back(allocation);
+}
+
+void DeletionQueue::next() {
+    lock_guard lock{queueMutex};
+
+    //the recording upload batch is submitted with a later value
+    const UploadQueue* uploads = device->uploadQueue();
+    const bool uploadRecording = uploads != nullptr && uploads->recording();
+
+    if(!uploadRecording && (!openBatch.handles.empty() || !openBatch.allocations.empty())) {
+        openBatch.value = device->timeline()->submitted();
+        retired.push_back(std::move(openBatch));
+        openBatch = Batch{};
+    }
+
+    while(!retired.empty() && device->timeline()->reached(retired.front().value)) {
+        destroy(retired.front());
+        retired.pop_front();
+    }
+}
+void DeletionQueue::clear() {
+    lock_guard lock{queueMutex};
+    ranges::for_each(retired, [this](Batch& batch) { destroy(batch); });
+    retired.clear();
+    destroy(openBatch);
+}
+
+void DeletionQueue::enqueueHandle(const Handle_Type type, const uint64_t handle) {
+    if(handle == 0) return;
+
+    lock_guard lock{queueMutex};
+    openBatch.handles.push_back(Entry{type, handle});
+}
+void DeletionQueue::destroy(Batch& batch) const {
+    ranges::for_each(batch.handles, [this](const Entry& entry) { destroy(entry); });
+    ranges::for_each(batch.allocations, [this](MemoryAllocation& allocation) { device->allocator()->free(allocation); });
+
+    batch.handles.clear();
+    batch.allocations.clear();
+}
+void DeletionQueue::destroy(const Entry& entry) const {
+    VkDevice vkDevice = device->get();
+
+    if constexpr(ResourceTracker::ENABLED) {
+        const ResourceTracker::Resource_Type tracked = trackedType(entry.type);
+        if(tracked != ResourceTracker::TYPES_SIZE) device->resourceTracker()->remove(tracked, entry.handle);
+    }
+
+    switch(entry.type) {
+        case TYPE_BUFFER:
+            vkDestroyBuffer(vkDevice, handleCast<VkBuffer>(entry.handle), HostAllocator::callbacks(HostAllocator::CATEGORY_RESOURCE));
+            break;
+        case TYPE_IMAGE:
+            vkDestroyImage(vkDevice, handleCast<VkImage>(entry.handle), HostAllocator::callbacks(HostAllocator::CATEGORY_RESOURCE));
+            break;
+        case TYPE_IMAGE_VIEW:
+            vkDestroyImageView(vkDevice, handleCast<VkImageView>(entry.handle), HostAllocator::callbacks(HostAllocator::CATEGORY_RESOURCE));
+            break;
+        case TYPE_SAMPLER:
+            vkDestroySampler(vkDevice, handleCast<VkSampler>(entry.handle), HostAllocator::callbacks(HostAllocator::CATEGORY_RESOURCE));
+            break;
+        case TYPE_PIPELINE:
+            vkDestroyPipeline(vkDevice, handleCast<VkPipeline>(entry.handle), HostAllocator::callbacks(HostAllocator::CATEGORY_PIPELINE));
+            break;
+        case TYPE_DESCRIPTOR_POOL:
+            vkDestroyDescriptorPool(vkDevice, handleCast<VkDescriptorPool>(entry.handle),
+                HostAllocator::callbacks(HostAllocator::CATEGORY_DESCRIPTOR));
+            break;
+        case TYPE_FRAMEBUFFER:
+            vkDestroyFramebuffer(vkDevice, handleCast<VkFramebuffer>(entry.handle), HostAllocator::callbacks(HostAllocator::CATEGORY_SWAPCHAIN));
+            break;
+        case TYPE_RENDER_PASS:
+            vkDestroyRenderPass(vkDevice, handleCast<VkRenderPass>(entry.handle), HostAllocator::callbacks(HostAllocator::CATEGORY_SWAPCHAIN));
+            break;
+        case TYPE_SWAPCHAIN:
+            vkDestroySwapchainKHR(vkDevice, handleCast<VkSwapchainKHR>(entry.handle), HostAllocator::callbacks(HostAllocator::CATEGORY_SWAPCHAIN));
+            break;
+        case TYPE_SEMAPHORE:
+            //only the swapchain retires semaphores
+            vkDestroySemaphore(vkDevice, handleCast<VkSemaphore>(entry.handle), HostAllocator::callbacks(HostAllocator::CATEGORY_SWAPCHAIN));
+            break;
+        case TYPE_COMMAND_POOL:
+            //frees the command buffers of the pool
+            vkDestroyCommandPool(vkDevice, handleCast<VkCommandPool>(entry.handle), HostAllocator::callbacks(HostAllocator::CATEGORY_DEVICE));
+            break;
+        default:
+            //called from destructors, must not throw
+            CTH_WARN(true, "unknown handle type, handle leaked") details->add("type: {0}, handle: {1:#x}", static_cast<uint32_t>(entry.type),
+                entry.handle);
+    }
+}
+
+DeletionQueue::DeletionQueue(Device* device) : device(device) {}
+DeletionQueue::~DeletionQueue() { clear(); }
+
+size_t DeletionQueue::pending() const {
+    lock_guard lock{queueMutex};
+
+    size_t count = openBatch.handles.size() + openBatch.allocations.size();
+    for(const auto& batch : retired) count += batch.handles.size() + batch.allocations.size();
+    return count;
+}
+
+} // namespace cth
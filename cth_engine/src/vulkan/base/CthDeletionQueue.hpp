@@ -0,0 +1,115 @@
+#pragma once
+#include "CthTimeline.hpp"
+
+#include "vulkan/memory/allocator/CthMemoryAllocator.hpp"
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+
+namespace cth {
+using namespace std;
+class Device;
+
+/**
+ * \brief defers the destruction of vulkan objects and memory until the gpu stopped using them
+ * \note objects enqueued between two next() calls form a batch,
+ * next() tags the batch with the last submitted value of the devices timeline and destroys it once the value was reached
+ * \note thread safe
+ */
+class DeletionQueue {
+public:
+    enum Handle_Type : uint32_t {
+        TYPE_BUFFER,
+        TYPE_IMAGE,
+        TYPE_IMAGE_VIEW,
+        TYPE_SAMPLER,
+        TYPE_PIPELINE,
+        TYPE_DESCRIPTOR_POOL,
+        TYPE_FRAMEBUFFER,
+        TYPE_RENDER_PASS,
+        TYPE_SWAPCHAIN,
+        TYPE_SEMAPHORE,
+        TYPE_COMMAND_POOL,
+        TYPES_SIZE
+    };
+
+    /**
+     * \brief destroys handle once everything submitted up to the next next() call finished
+     * \note VK_NULL_HANDLE is ignored
+     */
+    template<typename T>
+    void enqueue(Handle_Type type, T handle) { enqueueHandle(type, handleId(handle)); }
+    /**
+     * \brief returns allocation to the devices memory allocator once everything submitted up to the next next() call finished
+     */
+    void enqueue(const MemoryAllocation& allocation);
+
+    /**
+     * \brief tags the open batch with the last submitted timeline value and destroys every batch whose value was reached
+     * \note call after the work using the enqueued objects was submitted, e.g. after the frame submit
+     * \note the open batch stays open while the upload queue is recording, the recording batch may still use its objects
+     */
+    void next();
+    /**
+     * \brief destroys everything immediately
+     * \note the device must be idle
+     */
+    void clear();
+
+private:
+    struct Entry {
+        Handle_Type type;
+        uint64_t handle;
+    };
+    struct Batch {
+        vector<Entry> handles{};
+        vector<MemoryAllocation> allocations{};
+        Timeline::Value value = 0; /*timeline value that retires the batch*/
+    };
+
+    void enqueueHandle(Handle_Type type, uint64_t handle);
+    /**
+     * \note requires the queue mutex
+     */
+    void destroy(Batch& batch) const;
+    void destroy(const Entry& entry) const;
+
+    template<typename T>
+    [[nodiscard]] static uint64_t handleId(T handle) {
+        //non dispatchable handles are pointers on 64 bit and integers on 32 bit platforms
+        if constexpr(is_pointer_v<T>) return reinterpret_cast<uint64_t>(handle);
+        else return static_cast<uint64_t>(handle);
+    }
+    template<typename T>
+    [[nodiscard]] static T handleCast(const uint64_t id) {
+        if constexpr(is_pointer_v<T>) return reinterpret_cast<T>(id);
+        else return static_cast<T>(id);
+    }
+
+    Device* device;
+    Batch openBatch{};
+    deque<Batch> retired{};
+    mutable mutex queueMutex{};
+
+public:
+    explicit DeletionQueue(Device* device);
+    ~DeletionQueue();
+
+    /**
+     * \return number of enqueued objects and allocations
+     */
+    [[nodiscard]] size_t pending() const;
+
+    DeletionQueue(const DeletionQueue& other) = delete;
+    DeletionQueue(DeletionQueue&& other) = delete;
+    DeletionQueue& operator=(const DeletionQueue& other) = delete;
+    DeletionQueue& operator=(DeletionQueue&& other) = delete;
+};
+
+} // namespace cth
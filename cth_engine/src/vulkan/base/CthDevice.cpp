@@ -1,13 +1,23 @@
 #include "CthDevice.hpp"
 
+#include "CthDeletionQueue.hpp"
 #include "CthInstance.hpp"
+#include "CthTimeline.hpp"
 
+#include "vulkan/debug/CthResourceTracker.hpp"
+#include "vulkan/memory/allocator/CthHostAllocator.hpp"
+#include "vulkan/memory/allocator/CthMemoryAllocator.hpp"
+#include "vulkan/memory/allocator/CthMemoryStats.hpp"
+#include "vulkan/memory/transfer/CthUploadQueue.hpp"
 #include "vulkan/pipeline/shader/CthShader.hpp"
 #include "vulkan/surface/CthWindow.hpp"
 #include "vulkan/utility/CthVkUtils.hpp"
 
 #include <cth/cth_log.hpp>
 
+#include <bit>
+#include <optional>
+
 
 
 namespace cth {
@@ -26,6 +36,17 @@ vector<uint32_t> Device::checkDeviceFeatureSupport(const VkPhysicalDevice& devic
 
     return missingFeatures;
 }
+bool Device::timelineSemaphoreSupport(const VkPhysicalDevice physical_device) {
+    VkPhysicalDeviceTimelineSemaphoreFeatures timelineFeatures{};
+    timelineFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+
+    VkPhysicalDeviceFeatures2 features{};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features.pNext = &timelineFeatures;
+
+    vkGetPhysicalDeviceFeatures2(physical_device, &features);
+    return timelineFeatures.timelineSemaphore == VK_TRUE;
+}
 VkSampleCountFlagBits Device::evaluateMaxUsableSampleCount() const {
     const VkSampleCountFlags counts = physicalProperties.limits.framebufferColorSampleCounts &
         physicalProperties.limits.framebufferDepthSampleCounts;
@@ -52,28 +73,47 @@ QueueFamilyIndices Device::findQueueFamilies(const VkPhysicalDevice physical_dev
     QueueFamilyIndices indices;
     vector<uint32_t> graphicFamilies{};
     vector<uint32_t> presentFamilies{};
+    vector<uint32_t> transferFamilies{};
 
 
     for(auto [i, queueFamily] : queueFamilies | views::enumerate) {
         if(queueFamily.queueCount == 0) continue;
 
         if(queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) graphicFamilies.push_back(i);
+        //graphics and compute families implicitly support transfer
+        else if(queueFamily.queueFlags & (VK_QUEUE_TRANSFER_BIT | VK_QUEUE_COMPUTE_BIT)) transferFamilies.push_back(i);
 
-        if(window->surfaceSupport(physical_device, i)) presentFamilies.push_back(i);
+        if(!headless() && window->surfaceSupport(physical_device, i)) presentFamilies.push_back(i);
     }
 
-    //iterate through all possible combinations of graphic and present indices
-    for(const auto graphicFamily : graphicFamilies) {
-        indices.graphicsFamilyIndex = graphicFamily;
-        for(const auto presentFamily : presentFamilies) {
-            if(graphicFamily == presentFamily) continue;
-            indices.presentFamilyIndex = presentFamily;
-            if(indices.complete()) return indices;
-        }
+    //prefer transfer only families, they map to the dma engines
+    ranges::stable_sort(transferFamilies, {}, [&queueFamilies](const uint32_t family) {
+        return (queueFamilies[family].queueFlags & VK_QUEUE_COMPUTE_BIT) != 0;
+    });
+
+    if(headless()) {
+        if(graphicFamilies.empty()) return indices;
+
+        indices.graphicsFamilyIndex = graphicFamilies[0];
+        indices.transferFamilyIndex = transferFamilies.empty() ? graphicFamilies[0] : transferFamilies[0];
+        return indices;
     }
 
+    if(graphicFamilies.empty() || presentFamilies.empty()) return indices;
+
+    //prefer a family that renders and presents, the swapchain images never change their owner
+    const auto universal = ranges::find_first_of(graphicFamilies, presentFamilies);
+    indices.graphicsFamilyIndex = universal == graphicFamilies.end() ? graphicFamilies[0] : *universal;
+    indices.presentFamilyIndex = universal == graphicFamilies.end() ? presentFamilies[0] : *universal;
+    indices.transferFamilyIndex = transferFamilies.empty() ? indices.graphicsFamilyIndex : transferFamilies[0];
+
     return indices;
 }
+vector<const char*> Device::requiredExtensions() const {
+    vector<const char*> extensions(REQUIRED_DEVICE_EXTENSIONS.begin(), REQUIRED_DEVICE_EXTENSIONS.end());
+    if(!headless()) extensions.insert(extensions.end(), PRESENT_DEVICE_EXTENSIONS.begin(), PRESENT_DEVICE_EXTENSIONS.end());
+    return extensions;
+}
 vector<string> Device::checkDeviceExtensionSupport(VkPhysicalDevice physical_device) const {
     uint32_t extensionCount = 0;
     vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &extensionCount, nullptr);
@@ -81,7 +121,7 @@ vector<string> Device::checkDeviceExtensionSupport(VkPhysicalDevice physical_dev
     vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &extensionCount, availableExtensions.data());
 
     vector<string> missingExtensions{};
-    ranges::for_each(REQUIRED_DEVICE_EXTENSIONS, [&missingExtensions, availableExtensions](string_view required_extension_name) {
+    ranges::for_each(requiredExtensions(), [&missingExtensions, &availableExtensions](string_view required_extension_name) {
         const bool missing = ranges::none_of(availableExtensions, [required_extension_name](const VkExtensionProperties& available_extension) {
             return available_extension.extensionName == required_extension_name;
         });
@@ -89,6 +129,20 @@ vector<string> Device::checkDeviceExtensionSupport(VkPhysicalDevice physical_dev
     });
     return missingExtensions;
 }
+vector<const char*> Device::supportedOptionalExtensions(VkPhysicalDevice physical_device) const {
+    uint32_t extensionCount = 0;
+    vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &extensionCount, nullptr);
+    vector<VkExtensionProperties> availableExtensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &extensionCount, availableExtensions.data());
+
+    vector<const char*> supportedExtensions{};
+    ranges::copy_if(OPTIONAL_DEVICE_EXTENSIONS, back_inserter(supportedExtensions), [&availableExtensions](const string_view optional_extension_name) {
+        return ranges::any_of(availableExtensions, [optional_extension_name](const VkExtensionProperties& available_extension) {
+            return available_extension.extensionName == optional_extension_name;
+        });
+    });
+    return supportedExtensions;
+}
 SwapchainSupportDetails Device::querySwapchainSupport(const VkPhysicalDevice physical_device) const {
     SwapchainSupportDetails details{};
     details.capabilities = window->surfaceCapabilities(physical_device);
@@ -103,34 +157,45 @@ bool Device::physicalDeviceSuitable(VkPhysicalDevice physical_device) const {
     string details{};
     bool suitable = true;
 
+    //every check has to pass, the details list all failed ones
     const QueueFamilyIndices indices = findQueueFamilies(physical_device);
-    if(!(suitable = indices.complete())) {
+    const bool familiesSupported = headless() ? indices.graphicsFamily() : indices.complete();
+    suitable &= familiesSupported;
+    if(!familiesSupported) {
         details += "\n required queue family not supported\n";
         if(!indices.graphicsFamily()) details += "\tgraphics queue family missing\n";
         if(!indices.presentFamily()) details += "\tpresent queue family missing\n";
     }
 
     auto missingExtensions = checkDeviceExtensionSupport(physical_device);
-    if(!(suitable = missingExtensions.empty())) {
+    suitable &= missingExtensions.empty();
+    if(!missingExtensions.empty()) {
         details += "\n missing device extensions:\n";
         ranges::for_each(missingExtensions, [&details](const string_view extension) { details += '\t' + string(extension) + '\n'; });
     }
 
-    const SwapchainSupportDetails swapChainSupport = querySwapchainSupport(physical_device);
-    const bool swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
-    if(!(suitable = swapChainAdequate)) {
+    const SwapchainSupportDetails swapChainSupport = headless() ? SwapchainSupportDetails{} : querySwapchainSupport(physical_device);
+    const bool swapChainAdequate = headless() || (!swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty());
+    suitable &= swapChainAdequate;
+    if(!swapChainAdequate) {
         details += "\n swapchain capabilities insufficient:";
         if(swapChainSupport.formats.empty()) details += "\tno swap chain formats available\n";
         if(swapChainSupport.presentModes.empty()) details += "\tno swap chain present modes available\n";
     }
 
     const auto missingFeatures = checkDeviceFeatureSupport(physical_device);
-    if(!(suitable = missingFeatures.empty())) {
+    suitable &= missingFeatures.empty();
+    if(!missingFeatures.empty()) {
         details += "\n missing device features:\n";
         ranges::for_each(missingFeatures,
             [&details](const uint32_t feature) { details += '\t' + string(deviceFeatureIndexToString(feature)) + '\n'; });
     }
 
+    if(!timelineSemaphoreSupport(physical_device)) {
+        suitable = false;
+        details += "\n timeline semaphores not supported\n";
+    }
+
     if(!suitable) cth::log::msg<except::INFO>("device {} not suitable\n{}", physicalProperties.deviceName, details);
     return suitable;
 }
@@ -153,16 +218,23 @@ void Device::pickPhysicalDevice() {
 
 
     vkGetPhysicalDeviceProperties(vkPhysicalDevice, &physicalProperties);
+    vkGetPhysicalDeviceMemoryProperties(vkPhysicalDevice, &physicalMemoryProperties);
 
     cth::log::msg<except::INFO>("chosen physical device: {}", physicalProperties.deviceName);
+    if(headless()) cth::log::msg<except::INFO>("headless device, presentation disabled");
 }
 
 
 
 void Device::createLogicalDevice() {
-    QueueFamilyIndices indices = findQueueFamilies(vkPhysicalDevice);
-
-    const vector<uint32_t> uniqueQueueFamilies = {indices.graphicsFamilyIndex, indices.presentFamilyIndex};
+    familyIndices = findQueueFamilies(vkPhysicalDevice);
+
+    vector<uint32_t> uniqueQueueFamilies = {familyIndices.graphicsFamilyIndex, familyIndices.presentFamilyIndex,
+        familyIndices.transferFamilyIndex};
+    if(headless()) uniqueQueueFamilies.erase(ranges::find(uniqueQueueFamilies, familyIndices.presentFamilyIndex));
+    ranges::sort(uniqueQueueFamilies);
+    const auto [first, last] = ranges::unique(uniqueQueueFamilies);
+    uniqueQueueFamilies.erase(first, last);
     vector<VkDeviceQueueCreateInfo> queueCreateInfos;
 
     float queuePriority = 1.0f;
@@ -182,9 +254,24 @@ void Device::createLogicalDevice() {
     createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
     createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
+    vector<const char*> extensions = requiredExtensions();
+    const vector<const char*> optionalExtensions = supportedOptionalExtensions(vkPhysicalDevice);
+    extensions.insert(extensions.end(), optionalExtensions.begin(), optionalExtensions.end());
+
+    memoryBudgetEnabled = ranges::any_of(optionalExtensions, [](const string_view extension) {
+        return extension == VK_EXT_MEMORY_BUDGET_EXTENSION_NAME;
+    });
+
     createInfo.pEnabledFeatures = &REQUIRED_DEVICE_FEATURES;
-    createInfo.enabledExtensionCount = static_cast<uint32_t>(REQUIRED_DEVICE_EXTENSIONS.size());
-    createInfo.ppEnabledExtensionNames = REQUIRED_DEVICE_EXTENSIONS.data();
+
+    //frames and uploads are paced by the graphics timeline
+    VkPhysicalDeviceTimelineSemaphoreFeatures timelineFeatures{};
+    timelineFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+    timelineFeatures.timelineSemaphore = VK_TRUE;
+    createInfo.pNext = &timelineFeatures;
+
+    createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+    createInfo.ppEnabledExtensionNames = extensions.data();
 
     // might not really be necessary anymore because device specific validation layers
     // have been deprecated
@@ -194,28 +281,27 @@ void Device::createLogicalDevice() {
     } else createInfo.enabledLayerCount = 0;
 
 
-    const VkResult createResult = vkCreateDevice(vkPhysicalDevice, &createInfo, nullptr, &vkDevice);
+    const VkResult createResult = vkCreateDevice(vkPhysicalDevice, &createInfo, HostAllocator::callbacks(HostAllocator::CATEGORY_DEVICE), &vkDevice);
     CTH_STABLE_ERR(createResult != VK_SUCCESS, "failed to create logical device")
         throw cth::except::vk_result_exception{createResult, details->exception()};
 
-    vkGetDeviceQueue(vkDevice, indices.graphicsFamilyIndex, 0, &vkGraphicsQueue);
-    vkGetDeviceQueue(vkDevice, indices.presentFamilyIndex, 0, &vkPresentQueue);
-}
-
-void Device::createCommandPool() {
-    const QueueFamilyIndices queueFamilyIndices = findPhysicalQueueFamilies();
-
-    VkCommandPoolCreateInfo poolInfo = {};
-    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-    poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamilyIndex;
-    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT |
-        VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    vkGetDeviceQueue(vkDevice, familyIndices.graphicsFamilyIndex, 0, &vkGraphicsQueue);
+    if(!headless()) vkGetDeviceQueue(vkDevice, familyIndices.presentFamilyIndex, 0, &vkPresentQueue);
+    vkGetDeviceQueue(vkDevice, familyIndices.transferFamilyIndex, 0, &vkTransferQueue);
 
+    if(familyIndices.dedicatedTransfer())
+        cth::log::msg<except::INFO>("dedicated transfer queue family: {}", familyIndices.transferFamilyIndex);
+    if(familyIndices.dedicatedPresent())
+        cth::log::msg<except::INFO>("dedicated present queue family: {}", familyIndices.presentFamilyIndex);
+}
 
-    const VkResult createResult = vkCreateCommandPool(vkDevice, &poolInfo, nullptr, &commandPool);
-    CTH_STABLE_ERR(createResult != VK_SUCCESS, "failed to create command pool")
-        throw cth::except::vk_result_exception{createResult, details->exception()};
+void Device::createResourceTracker() {
+    if constexpr(ResourceTracker::ENABLED) tracker = make_unique<ResourceTracker>();
 }
+void Device::createTimeline() { graphicsTimeline = make_unique<Timeline>(this); }
+void Device::createMemoryAllocator() { memoryAllocator = make_unique<MemoryAllocator>(this); }
+void Device::createUploadQueue() { uploads = make_unique<UploadQueue>(this); }
+void Device::createDeletionQueue() { deletion = make_unique<DeletionQueue>(this); }
 void Device::initShaders() {
 
     //TEMP move this
@@ -244,131 +330,120 @@ VkFormat Device::findSupportedFormat(const std::vector<VkFormat>& candidates, co
     }
     CTH_STABLE_ERR(true, "format unsupported") throw cth::except::data_exception{features, details->exception()};
 }
-uint32_t Device::findMemoryType(const uint32_t type_filter, const VkMemoryPropertyFlags properties) const {
-    VkPhysicalDeviceMemoryProperties memProperties;
-    vkGetPhysicalDeviceMemoryProperties(vkPhysicalDevice, &memProperties);
-
-    for(uint32_t i = 0; i < memProperties.memoryTypeCount; i++)
-        if((type_filter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties)
-            return i;
+uint32_t Device::findMemoryType(const uint32_t type_filter, const VkMemoryPropertyFlags required, const VkMemoryPropertyFlags preferred,
+    const VkMemoryPropertyFlags not_preferred) const {
+    optional<uint32_t> bestType = nullopt;
+    int bestScore = numeric_limits<int>::min();
+    VkDeviceSize bestHeapSize = 0;
 
-    CTH_STABLE_ERR(true, "no suitable memory type available") throw details->exception();
-}
+    for(uint32_t i = 0; i < physicalMemoryProperties.memoryTypeCount; i++) {
+        const VkMemoryType& type = physicalMemoryProperties.memoryTypes[i];
+        if(!(type_filter & (1 << i)) || (type.propertyFlags & required) != required) continue;
 
-//---------------------------
-// Buffer Helper Functions
-//---------------------------
+        const int score = popcount(type.propertyFlags & preferred) - popcount(type.propertyFlags & not_preferred);
+        const VkDeviceSize heapSize = physicalMemoryProperties.memoryHeaps[type.heapIndex].size;
 
-VkCommandBuffer Device::beginSingleTimeCommands() const {
-    VkCommandBufferAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    allocInfo.commandPool = commandPool;
-    allocInfo.commandBufferCount = 1;
+        if(score < bestScore || (score == bestScore && heapSize <= bestHeapSize)) continue;
 
-    VkCommandBuffer commandBuffer;
-    vkAllocateCommandBuffers(vkDevice, &allocInfo, &commandBuffer);
+        bestType = i;
+        bestScore = score;
+        bestHeapSize = heapSize;
+    }
 
-    VkCommandBufferBeginInfo beginInfo{};
-    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    CTH_STABLE_ERR(bestType == nullopt, "no suitable memory type available") {
+        details->add("required: {0}, preferred: {1}, not preferred: {2}", required, preferred, not_preferred);
+        throw details->exception();
+    }
 
-    vkBeginCommandBuffer(commandBuffer, &beginInfo);
-    return commandBuffer;
+    return *bestType;
 }
-void Device::endSingleTimeCommands(VkCommandBuffer command_buffer) const {
-    vkEndCommandBuffer(command_buffer);
 
-    VkSubmitInfo submitInfo{};
-    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &command_buffer;
+MemoryStats Device::memoryStats() const {
+    MemoryStats stats = memoryAllocator->stats();
+    if(!memoryBudgetEnabled) return stats;
 
-    vkQueueSubmit(vkGraphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
-    vkQueueWaitIdle(vkGraphicsQueue);
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties{};
+    budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
 
-    vkFreeCommandBuffers(vkDevice, commandPool, 1, &command_buffer);
+    VkPhysicalDeviceMemoryProperties2 memoryProperties2{};
+    memoryProperties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+    memoryProperties2.pNext = &budgetProperties;
+
+    vkGetPhysicalDeviceMemoryProperties2(vkPhysicalDevice, &memoryProperties2);
+
+    for(uint32_t i = 0; i < stats.heaps.size(); i++) {
+        stats.heaps[i].usage = budgetProperties.heapUsage[i];
+        stats.heaps[i].budget = budgetProperties.heapBudget[i];
+    }
+    stats.budgetAvailable = true;
+
+    return stats;
 }
 
+//---------------------------
+// Buffer Helper Functions
+//---------------------------
+
 void Device::createBuffer(const VkDeviceSize size, const VkBufferUsageFlags usage, const VkMemoryPropertyFlags properties,
-    VkBuffer& buffer, VkDeviceMemory& buffer_memory) const {
+    VkBuffer& buffer, MemoryAllocation& buffer_memory) const {
     VkBufferCreateInfo bufferInfo{};
     bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
     bufferInfo.size = size;
     bufferInfo.usage = usage;
     bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
-    const VkResult createResult = vkCreateBuffer(vkDevice, &bufferInfo, nullptr, &buffer);
+    const VkResult createResult = vkCreateBuffer(vkDevice, &bufferInfo, HostAllocator::callbacks(HostAllocator::CATEGORY_RESOURCE), &buffer);
     CTH_STABLE_ERR(createResult != VK_SUCCESS, "failed to create buffer")
         throw cth::except::vk_result_exception{createResult, details->exception()};
 
     VkMemoryRequirements memRequirements;
     vkGetBufferMemoryRequirements(vkDevice, buffer, &memRequirements);
 
-    VkMemoryAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memRequirements.size;
-    allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+    VkMemoryPropertyFlags preferred = 0;
+    VkMemoryPropertyFlags notPreferred = 0;
+
+    if(properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+        //staging sources are only read once by the gpu, keep them out of the small device local host visible heap
+        if(usage == VK_BUFFER_USAGE_TRANSFER_SRC_BIT) notPreferred = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+        //readback
+        else if(usage == VK_BUFFER_USAGE_TRANSFER_DST_BIT) preferred = VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+        //dynamic data is read by the gpu every frame
+        else preferred = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    } else if(properties & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) notPreferred = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
 
-    const VkResult allocResult = vkAllocateMemory(vkDevice, &allocInfo, nullptr, &buffer_memory);
-    CTH_STABLE_ERR(allocResult != VK_SUCCESS, "failed to allocate buffer memory")
-        throw cth::except::vk_result_exception{allocResult, details->exception()};
+    buffer_memory = memoryAllocator->allocate(memRequirements, properties, true, preferred, notPreferred);
 
-    vkBindBufferMemory(vkDevice, buffer, buffer_memory, 0);
+    const VkResult bindResult = vkBindBufferMemory(vkDevice, buffer, buffer_memory.memory, buffer_memory.offset);
+    CTH_STABLE_ERR(bindResult != VK_SUCCESS, "failed to bind buffer memory")
+        throw cth::except::vk_result_exception{bindResult, details->exception()};
 }
-void Device::copyBuffer(VkBuffer src_buffer, VkBuffer dst_buffer, const VkDeviceSize size, const VkDeviceSize src_offset,
+uint64_t Device::copyBuffer(VkBuffer src_buffer, VkBuffer dst_buffer, const VkDeviceSize size, const VkDeviceSize src_offset,
     const VkDeviceSize dst_offset) const {
-    VkCommandBuffer commandBuffer = beginSingleTimeCommands();
-
-    VkBufferCopy copyRegion;
-    copyRegion.srcOffset = src_offset;
-    copyRegion.dstOffset = dst_offset;
-    copyRegion.size = size;
-    vkCmdCopyBuffer(commandBuffer, src_buffer, dst_buffer, 1, &copyRegion);
-
-    endSingleTimeCommands(commandBuffer);
+    return uploads->copyResident(src_buffer, dst_buffer, size, src_offset, dst_offset);
+}
+uint64_t Device::copyBuffer(VkBuffer src_buffer, VkBuffer dst_buffer, const span<const VkBufferCopy> regions) const {
+    return uploads->copyResident(src_buffer, dst_buffer, regions);
 }
-void Device::copyBufferToImage(VkBuffer buffer, VkImage image, const uint32_t width, const uint32_t height,
+uint64_t Device::copyBufferToImage(VkBuffer buffer, VkImage image, const uint32_t width, const uint32_t height,
     const uint32_t layer_count) const {
-    VkCommandBuffer commandBuffer = beginSingleTimeCommands();
-
-    VkBufferImageCopy region;
-    region.bufferOffset = 0;
-    region.bufferRowLength = 0;
-    region.bufferImageHeight = 0;
-
-    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    region.imageSubresource.mipLevel = 0;
-    region.imageSubresource.baseArrayLayer = 0;
-    region.imageSubresource.layerCount = layer_count;
-
-    region.imageOffset = {0, 0, 0};
-    region.imageExtent = {width, height, 1};
-
-    vkCmdCopyBufferToImage(commandBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-    endSingleTimeCommands(commandBuffer);
+    return uploads->copy(buffer, image, width, height, layer_count);
 }
 void Device::createImageWithInfo(const VkImageCreateInfo& image_info, const VkMemoryPropertyFlags properties, VkImage& image,
-    VkDeviceMemory& image_memory) const {
+    MemoryAllocation& image_memory) const {
 
-    const VkResult createResult = vkCreateImage(vkDevice, &image_info, nullptr, &image);
+    const VkResult createResult = vkCreateImage(vkDevice, &image_info, HostAllocator::callbacks(HostAllocator::CATEGORY_RESOURCE), &image);
     CTH_STABLE_ERR(createResult != VK_SUCCESS, "failed to create image")
         throw cth::except::vk_result_exception{createResult, details->exception()};
 
     VkMemoryRequirements memRequirements;
     vkGetImageMemoryRequirements(vkDevice, image, &memRequirements);
 
-    VkMemoryAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memRequirements.size;
-    allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
-
-    const VkResult allocResult = vkAllocateMemory(vkDevice, &allocInfo, nullptr, &image_memory);
-
-    CTH_STABLE_ERR(allocResult != VK_SUCCESS, "failed to allocate image memory")
-        throw cth::except::vk_result_exception{allocResult, details->exception()};
+    //transient attachments never leave tile memory on tilers, lazily allocated memory is only committed if they do
+    const VkMemoryPropertyFlags preferred = image_info.usage & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT ? VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT : 0;
+    const VkMemoryPropertyFlags notPreferred = properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT ? 0 : VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+    image_memory = memoryAllocator->allocate(memRequirements, properties, image_info.tiling == VK_IMAGE_TILING_LINEAR, preferred, notPreferred);
 
-    const VkResult bindResult = vkBindImageMemory(vkDevice, image, image_memory, 0);
+    const VkResult bindResult = vkBindImageMemory(vkDevice, image, image_memory.memory, image_memory.offset);
     CTH_STABLE_ERR(bindResult != VK_SUCCESS, "failed to bind image memory")
         throw cth::except::vk_result_exception{bindResult, details->exception()};
 }
@@ -376,16 +451,29 @@ void Device::createImageWithInfo(const VkImageCreateInfo& image_info, const VkMe
 Device::Device(Window* window, Instance* instance) : window(window), instance(instance) {
     pickPhysicalDevice();
     createLogicalDevice();
-    createCommandPool();
+    createResourceTracker();
+    createTimeline();
+    createMemoryAllocator();
+    createUploadQueue();
+    createDeletionQueue();
     initShaders();
 }
 Device::~Device() {
-    vkDestroyCommandPool(vkDevice, commandPool, nullptr);
+    vkDeviceWaitIdle(vkDevice);
+
+    //the staging ring enqueues its buffer
+    uploads = nullptr;
+    deletion = nullptr;
+    graphicsTimeline = nullptr;
 
     vertShader = nullptr;
     fragShader = nullptr;
 
-    vkDestroyDevice(vkDevice, nullptr);
+    memoryAllocator = nullptr;
+
+    vkDestroyDevice(vkDevice, HostAllocator::callbacks(HostAllocator::CATEGORY_DEVICE));
+
+    if constexpr(ResourceTracker::ENABLED) tracker->logReport();
 
     cth::log::msg<except::LOG>("destroyed device");
 }
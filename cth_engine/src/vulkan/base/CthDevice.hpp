@@ -1,6 +1,7 @@
 #pragma once
 #include <array>
 #include <memory>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -17,6 +18,13 @@ inline const string SHADER_BINARY_DIR = R"(res\bin\shader\)";
 class Instance;
 class Window;
 class Shader; //TEMP
+class MemoryAllocator;
+struct MemoryAllocation;
+struct MemoryStats;
+class UploadQueue;
+class ResourceTracker;
+class DeletionQueue;
+class Timeline;
 
 struct SwapchainSupportDetails {
     VkSurfaceCapabilitiesKHR capabilities{};
@@ -26,10 +34,17 @@ struct SwapchainSupportDetails {
 
 struct QueueFamilyIndices {
     uint32_t graphicsFamilyIndex = MAX;
-    uint32_t presentFamilyIndex = MAX;
+    uint32_t presentFamilyIndex = MAX; /*usually equals graphicsFamilyIndex, one queue renders and presents*/
+    uint32_t transferFamilyIndex = MAX; /*equals graphicsFamilyIndex if there is no dedicated transfer family*/
     [[nodiscard]] bool graphicsFamily() const { return graphicsFamilyIndex != MAX; }
     [[nodiscard]] bool presentFamily() const { return presentFamilyIndex != MAX; }
-    [[nodiscard]] bool complete() const { return graphicsFamily() && presentFamily() && graphicsFamilyIndex != presentFamilyIndex; }
+    [[nodiscard]] bool transferFamily() const { return transferFamilyIndex != MAX; }
+    [[nodiscard]] bool dedicatedTransfer() const { return transferFamily() && transferFamilyIndex != graphicsFamilyIndex; }
+    /**
+     * \return true if presenting requires a queue family ownership transfer of the swapchain images
+     */
+    [[nodiscard]] bool dedicatedPresent() const { return presentFamily() && presentFamilyIndex != graphicsFamilyIndex; }
+    [[nodiscard]] bool complete() const { return graphicsFamily() && presentFamily(); }
 
 private:
     static constexpr uint32_t MAX = numeric_limits<uint32_t>::max();
@@ -37,56 +52,94 @@ private:
 
 class Device {
 public:
-    static constexpr array<const char*, 2> REQUIRED_DEVICE_EXTENSIONS = {VK_KHR_SWAPCHAIN_EXTENSION_NAME, VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME};
+    static constexpr array<const char*, 1> REQUIRED_DEVICE_EXTENSIONS = {VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME};
+    /*required unless the device is headless*/
+    static constexpr array<const char*, 1> PRESENT_DEVICE_EXTENSIONS = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+    /*enabled if the physical device supports them*/
+    static constexpr array<const char*, 1> OPTIONAL_DEVICE_EXTENSIONS = {VK_EXT_MEMORY_BUDGET_EXTENSION_NAME};
     static constexpr VkPhysicalDeviceFeatures REQUIRED_DEVICE_FEATURES = []() {
         VkPhysicalDeviceFeatures features{};
         features.samplerAnisotropy = true;
         return features;
     }();
 
+    /**
+     * \note requires a window
+     */
     [[nodiscard]] SwapchainSupportDetails getSwapchainSupport() const { return querySwapchainSupport(vkPhysicalDevice); }
     /**
+     * \brief picks the memory type with the most preferred and fewest not preferred flags, ties go to the larger heap
+     * \param required flags the type must have
+     * \param preferred flags the type should have
+     * \param not_preferred flags the type should not have
+     * \note uses the memory properties cached at device creation
      * \throws cth::except::default_exception reason: no suitable memory type
      */
-    [[nodiscard]] uint32_t findMemoryType(uint32_t type_filter, VkMemoryPropertyFlags properties) const;
+    [[nodiscard]] uint32_t findMemoryType(uint32_t type_filter, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred = 0,
+        VkMemoryPropertyFlags not_preferred = 0) const;
     [[nodiscard]] QueueFamilyIndices findPhysicalQueueFamilies() const { return findQueueFamilies(vkPhysicalDevice); }
     /**
      *\throws cth::except::data_exception data: features param
      */
     [[nodiscard]] VkFormat findSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features) const;
     [[nodiscard]] VkSampleCountFlagBits evaluateMaxUsableSampleCount() const;
+    /**
+     * \brief collects the allocator stats and queries the heap usage and budget
+     * \note usage and budget come from VK_EXT_memory_budget if it is enabled, cheap enough to query every frame
+     */
+    [[nodiscard]] MemoryStats memoryStats() const;
 
     // Buffer Helper Functions
 
     /**
+     * \brief creates the buffer and binds it to a suballocated memory range
+     * \note host visible buffers prefer device local memory unless they are pure staging sources, readback buffers prefer host cached memory
      * \throws cth::except::vk_result_exception result of vkCreateBuffer()
      * \throws cth::except::vk_result_exception result of vkAllocateMemory()
+     * \throws cth::except::vk_result_exception result of vkBindBufferMemory()
      */
     void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties,
-        VkBuffer& buffer, VkDeviceMemory& buffer_memory) const;
+        VkBuffer& buffer, MemoryAllocation& buffer_memory) const;
 
-    [[nodiscard]] VkCommandBuffer beginSingleTimeCommands() const;
-    void endSingleTimeCommands(VkCommandBuffer command_buffer) const;
     //TODO why is this here
     /**
+     * \brief records the copy into the upload queue, the buffers may be in use by the graphics queue
      * \param size in bytes 
      * \param src_offset in bytes
      * \param dst_offset in bytes
+     * \return upload ticket of the copy
+     * \note does not wait for the copy, later submits on the graphics queue see the data once the upload queue was submitted
+     * \note ordered with the uploads recorded before and after it, see UploadQueue::copyResident()
+     */
+    uint64_t copyBuffer(VkBuffer src_buffer, VkBuffer dst_buffer, VkDeviceSize size, VkDeviceSize src_offset = 0, VkDeviceSize dst_offset = 0) const;
+    /**
+     * \brief records all regions with a single copy into the upload queue, the buffers may be in use by the graphics queue
+     * \param regions offsets and sizes in bytes
+     * \return upload ticket of the copy
+     * \note does not wait for the copy, later submits on the graphics queue see the data once the upload queue was submitted
+     */
+    uint64_t copyBuffer(VkBuffer src_buffer, VkBuffer dst_buffer, span<const VkBufferCopy> regions) const;
+    /**
+     * \brief records the copy into the upload queue
+     * \return upload ticket of the copy
+     * \note does not wait for the copy, later submits on the graphics queue see the data once the upload queue was submitted
      */
-    void copyBuffer(VkBuffer src_buffer, VkBuffer dst_buffer, VkDeviceSize size, VkDeviceSize src_offset = 0, VkDeviceSize dst_offset = 0) const;
-    void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layer_count) const;
+    uint64_t copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layer_count) const;
 
     //TODO put this into the image class maybe
     /**
+     * \brief creates the image and binds it to a suballocated memory range
+     * \note transient attachments prefer lazily allocated memory
      * \throws cth::except::vk_result_exception result of vkCreateImage()
      * \throws cth::except::vk_result_exception result of vkAllocateMemory()
      * \throws cth::except::vk_result_exception result of vkBindImageMemory()
      */
     void createImageWithInfo(const VkImageCreateInfo& image_info, VkMemoryPropertyFlags properties, VkImage& image,
-        VkDeviceMemory& image_memory) const;
+        MemoryAllocation& image_memory) const;
 
 
     VkPhysicalDeviceProperties physicalProperties;
+    VkPhysicalDeviceMemoryProperties physicalMemoryProperties;
 
     unique_ptr<Shader> vertShader; //TEMP move this
     unique_ptr<Shader> fragShader; //TEMP move this
@@ -95,8 +148,14 @@ private:
     //pickPhysicalDevice
     QueueFamilyIndices findQueueFamilies(VkPhysicalDevice physical_device) const;
     SwapchainSupportDetails querySwapchainSupport(VkPhysicalDevice physical_device) const;
+    /**
+     * \return REQUIRED_DEVICE_EXTENSIONS and PRESENT_DEVICE_EXTENSIONS unless headless
+     */
+    [[nodiscard]] vector<const char*> requiredExtensions() const;
     [[nodiscard]] vector<string> checkDeviceExtensionSupport(VkPhysicalDevice physical_device) const;
+    [[nodiscard]] vector<const char*> supportedOptionalExtensions(VkPhysicalDevice physical_device) const;
     [[nodiscard]] vector<uint32_t> checkDeviceFeatureSupport(const VkPhysicalDevice& device) const;
+    [[nodiscard]] static bool timelineSemaphoreSupport(VkPhysicalDevice physical_device);
     [[nodiscard]] bool physicalDeviceSuitable(VkPhysicalDevice physical_device) const;
     /**
      * \throws cth::except::default_exception reason: no vulkan gpus
@@ -108,11 +167,17 @@ private:
     * \throws cth::except::vk_result_exception result of vkCreateDevice()
     */
     void createLogicalDevice();
-    //createCommandPool
     /**
-     * \throws cth::except::vk_result_exception result of vkCreateCommandPool()
+     * \brief creates the resource tracker if ResourceTracker::ENABLED
+     */
+    void createResourceTracker();
+    /**
+     * \throws cth::except::vk_result_exception result of vkCreateSemaphore()
      */
-    void createCommandPool();
+    void createTimeline();
+    void createMemoryAllocator();
+    void createUploadQueue();
+    void createDeletionQueue();
     //initShaders
     void initShaders();
 
@@ -121,13 +186,24 @@ private:
 
 
     VkPhysicalDevice vkPhysicalDevice = VK_NULL_HANDLE;
-    VkCommandPool commandPool = VK_NULL_HANDLE;
 
     VkDevice vkDevice = VK_NULL_HANDLE;
     VkQueue vkGraphicsQueue = VK_NULL_HANDLE;
     VkQueue vkPresentQueue = VK_NULL_HANDLE;
+    VkQueue vkTransferQueue = VK_NULL_HANDLE;
+    QueueFamilyIndices familyIndices{};
+    bool memoryBudgetEnabled = false;
+
+    unique_ptr<ResourceTracker> tracker; /*nullptr if !ResourceTracker::ENABLED*/
+    unique_ptr<Timeline> graphicsTimeline;
+    unique_ptr<MemoryAllocator> memoryAllocator;
+    unique_ptr<UploadQueue> uploads;
+    unique_ptr<DeletionQueue> deletion;
 
 public:
+    /**
+     * \param window nullptr -> headless, no present queue and no swapchain support, see OffscreenRenderer
+     */
     explicit Device(Window* window, Instance* instance);
     ~Device();
 
@@ -136,10 +212,37 @@ public:
     Device(Device&&) = delete;
     Device& operator=(Device&&) = delete;
 
-    [[nodiscard]] VkCommandPool getCommandPool() const { return commandPool; }
+    /**
+     * \return VK_NULL_HANDLE if !dedicatedPresent()
+     */
     [[nodiscard]] VkDevice get() const { return vkDevice; } //TODO rename this to get()
+    [[nodiscard]] VkPhysicalDevice physical() const { return vkPhysicalDevice; }
     [[nodiscard]] VkQueue graphicsQueue() const { return vkGraphicsQueue; }
+    /**
+     * \return graphics queue if the present family is not dedicated, VK_NULL_HANDLE if headless
+     */
     [[nodiscard]] VkQueue presentQueue() const { return vkPresentQueue; }
+    /**
+     * \return dedicated transfer queue, graphics queue if there is no dedicated transfer family
+     */
+    [[nodiscard]] VkQueue transferQueue() const { return vkTransferQueue; }
+    [[nodiscard]] const QueueFamilyIndices& queueFamilies() const { return familyIndices; }
+    [[nodiscard]] bool dedicatedTransfer() const { return familyIndices.dedicatedTransfer(); }
+    [[nodiscard]] bool dedicatedPresent() const { return familyIndices.dedicatedPresent(); }
+    [[nodiscard]] bool headless() const { return window == nullptr; }
     [[nodiscard]] VkPhysicalDeviceLimits limits() const { return physicalProperties.limits; }
+    [[nodiscard]] const VkPhysicalDeviceMemoryProperties& memoryProperties() const { return physicalMemoryProperties; }
+    [[nodiscard]] bool memoryBudget() const { return memoryBudgetEnabled; }
+    [[nodiscard]] MemoryAllocator* allocator() const { return memoryAllocator.get(); }
+    /**
+     * \return nullptr if !ResourceTracker::ENABLED
+     */
+    [[nodiscard]] ResourceTracker* resourceTracker() const { return tracker.get(); }
+    [[nodiscard]] UploadQueue* uploadQueue() const { return uploads.get(); }
+    [[nodiscard]] DeletionQueue* deletionQueue() const { return deletion.get(); }
+    /**
+     * \return timeline of the graphics queue, signaled by the frame and upload submits
+     */
+    [[nodiscard]] Timeline* timeline() const { return graphicsTimeline.get(); }
 };
 } // namespace cth
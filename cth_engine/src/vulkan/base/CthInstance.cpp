@@ -5,6 +5,7 @@
 #endif
 
 
+#include "vulkan/memory/allocator/CthHostAllocator.hpp"
 #include "vulkan/utility/CthVkUtils.hpp"
 
 #include <cth/cth_log.hpp>
@@ -46,7 +47,7 @@ void Instance::create() {
         createInfo.pNext = nullptr;
     }
 
-    const VkResult createInstanceResult = vkCreateInstance(&createInfo, nullptr, &vkInstance);
+    const VkResult createInstanceResult = vkCreateInstance(&createInfo, HostAllocator::callbacks(HostAllocator::CATEGORY_INSTANCE), &vkInstance);
     CTH_STABLE_ERR(createInstanceResult != VK_SUCCESS, "VK: failed to create instance!")
         throw cth::except::vk_result_exception{createInstanceResult, details->exception()};
 }
@@ -121,9 +122,10 @@ Instance::Instance(string app_name, const vector<string>& required_extensions) :
 }
 Instance::~Instance() {
     if constexpr(ENABLE_VALIDATION_LAYERS) debugMessenger = nullptr;
-    vkDestroyInstance(vkInstance, nullptr);
+    vkDestroyInstance(vkInstance, HostAllocator::callbacks(HostAllocator::CATEGORY_INSTANCE));
 
     cth::log::msg<except::LOG>("destroyed instance");
+    if constexpr(ENABLE_VALIDATION_LAYERS) cth::log::msg<except::INFO>("{}", HostAllocator::report());
 }
 
 } // namespace cth
@@ -0,0 +1,77 @@
+#include "CthTimeline.hpp"
+
+#include "CthDevice.hpp"
+
+#include "vulkan/debug/CthResourceTracker.hpp"
+#include "vulkan/memory/allocator/CthHostAllocator.hpp"
+#include "vulkan/utility/CthVkUtils.hpp"
+
+#include <cth/cth_log.hpp>
+
+
+
+namespace cth {
+bool Timeline::reached(const Value value) {
+    if(value <= completedValue) return true;
+    return value <= completed();
+}
+Timeline::Value Timeline::completed() {
+    Value value = 0;
+    const VkResult counterResult = vkGetSemaphoreCounterValue(device->get(), semaphore, &value);
+    CTH_STABLE_ERR(counterResult != VK_SUCCESS, "failed to query timeline value")
+        throw cth::except::vk_result_exception{counterResult, details->exception()};
+
+    advance(value);
+    return value;
+}
+bool Timeline::wait(const Value value, const uint64_t timeout) {
+    if(value <= completedValue) return true;
+
+    CTH_ERR(value > submittedValue, "waiting on a value that was never submitted") {
+        details->add("value: {0}, submitted: {1}", value, submittedValue.load());
+        throw details->exception();
+    }
+
+    VkSemaphoreWaitInfo waitInfo{};
+    waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+    waitInfo.semaphoreCount = 1;
+    waitInfo.pSemaphores = &semaphore;
+    waitInfo.pValues = &value;
+
+    const VkResult waitResult = vkWaitSemaphores(device->get(), &waitInfo, timeout);
+    if(waitResult == VK_TIMEOUT) return false;
+
+    CTH_STABLE_ERR(waitResult != VK_SUCCESS, "failed to wait for timeline value")
+        throw cth::except::vk_result_exception{waitResult, details->exception()};
+
+    advance(value);
+    return true;
+}
+void Timeline::advance(const Value value) {
+    //other threads may have seen a newer value already
+    Value expected = completedValue;
+    while(expected < value && !completedValue.compare_exchange_weak(expected, value)) {}
+}
+
+Timeline::Timeline(Device* device) : device(device) {
+    VkSemaphoreTypeCreateInfo typeInfo{};
+    typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    typeInfo.initialValue = 0;
+
+    VkSemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semaphoreInfo.pNext = &typeInfo;
+
+    const VkResult createResult = vkCreateSemaphore(device->get(), &semaphoreInfo, HostAllocator::callbacks(HostAllocator::CATEGORY_DEVICE),
+        &semaphore);
+    CTH_STABLE_ERR(createResult != VK_SUCCESS, "failed to create timeline semaphore")
+        throw cth::except::vk_result_exception{createResult, details->exception()};
+    if constexpr(ResourceTracker::ENABLED) device->resourceTracker()->add(ResourceTracker::TYPE_SEMAPHORE, semaphore, 0, "Timeline");
+}
+Timeline::~Timeline() {
+    if constexpr(ResourceTracker::ENABLED) device->resourceTracker()->remove(ResourceTracker::TYPE_SEMAPHORE, semaphore);
+    vkDestroySemaphore(device->get(), semaphore, HostAllocator::callbacks(HostAllocator::CATEGORY_DEVICE));
+}
+
+} // namespace cth
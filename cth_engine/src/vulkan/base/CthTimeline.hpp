@@ -0,0 +1,82 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+
+
+namespace cth {
+using namespace std;
+class Device;
+
+/**
+ * \brief timeline semaphore signaled by the frame and upload submits on the graphics queue
+ * \note every signaling submit reserves the next value, a value is reached once its submit and everything submitted before it finished
+ * \note frames, upload batches and deferred deletions are tracked by values of this timeline instead of fences
+ * \note reached(), completed() and submitted() are thread safe, reserve() and the submit must not interleave with other submits
+ */
+class Timeline {
+public:
+    using Value = uint64_t;
+
+    /**
+     * \brief reserves the value for the next signaling submit on the graphics queue
+     * \note the submit must signal get() with the returned value before the next value is reserved
+     */
+    [[nodiscard]] Value reserve() { return ++submittedValue; }
+
+    /**
+     * \return true if value was reached, never blocks
+     * \throws cth::except::vk_result_exception result of vkGetSemaphoreCounterValue()
+     */
+    [[nodiscard]] bool reached(Value value);
+    /**
+     * \brief queries the current counter value of the semaphore
+     * \throws cth::except::vk_result_exception result of vkGetSemaphoreCounterValue()
+     */
+    Value completed();
+    /**
+     * \brief blocks until value was reached or the timeout expired
+     * \param timeout in nanoseconds
+     * \return false if the timeout expired
+     * \throws cth::except::vk_result_exception result of vkWaitSemaphores()
+     */
+    bool wait(Value value, uint64_t timeout = numeric_limits<uint64_t>::max());
+    /**
+     * \brief blocks until everything submitted so far finished
+     */
+    void waitIdle() { wait(submitted()); }
+
+private:
+    /**
+     * \brief raises the cached completed value to value
+     */
+    void advance(Value value);
+
+    Device* device;
+    VkSemaphore semaphore = VK_NULL_HANDLE;
+
+    atomic<Value> submittedValue = 0;
+    atomic<Value> completedValue = 0; /*last counter value seen by the host*/
+
+public:
+    /**
+     * \throws cth::except::vk_result_exception result of vkCreateSemaphore()
+     */
+    explicit Timeline(Device* device);
+    ~Timeline();
+
+    [[nodiscard]] VkSemaphore get() const { return semaphore; }
+    /**
+     * \return last reserved value
+     */
+    [[nodiscard]] Value submitted() const { return submittedValue; }
+
+    Timeline(const Timeline& other) = delete;
+    Timeline(Timeline&& other) = delete;
+    Timeline& operator=(const Timeline& other) = delete;
+    Timeline& operator=(Timeline&& other) = delete;
+};
+
+} // namespace cth
@@ -1,6 +1,7 @@
 #include "CthDebugMessenger.hpp"
 
 #include <vulkan/base/CthInstance.hpp>
+#include <vulkan/memory/allocator/CthHostAllocator.hpp>
 #include <vulkan/utility/CthVkUtils.hpp>
 
 #include <cth/cth_log.hpp>
@@ -29,7 +30,7 @@ void DebugMessenger::init(Instance* instance) {
 
     CTH_STABLE_ERR(func == nullptr, "vkGetInstanceProcAddr returned nullptr") throw details->exception();
 
-    const VkResult createResult = func(instance->get(), &info, nullptr, &vkMessenger);
+    const VkResult createResult = func(instance->get(), &info, HostAllocator::callbacks(HostAllocator::CATEGORY_INSTANCE), &vkMessenger);
 
     CTH_STABLE_ERR(createResult != VK_SUCCESS, "failed to set up debug messenger")
         throw cth::except::vk_result_exception{createResult, details->exception()};
@@ -41,7 +42,7 @@ void DebugMessenger::destroy() {
     const auto func = reinterpret_cast<PFN_vkDestroyDebugUtilsMessengerEXT>(
         vkGetInstanceProcAddr(instance->get(), "vkDestroyDebugUtilsMessengerEXT"));
 
-    if(func != nullptr) func(instance->get(), vkMessenger, nullptr);
+    if(func != nullptr) func(instance->get(), vkMessenger, HostAllocator::callbacks(HostAllocator::CATEGORY_INSTANCE));
     vkMessenger = VK_NULL_HANDLE;
     instance = nullptr;
 }
@@ -0,0 +1,180 @@
+#include "CthGpuProfiler.hpp"
+
+#include "vulkan/base/CthDevice.hpp"
+#include "vulkan/debug/CthResourceTracker.hpp"
+#include "vulkan/memory/allocator/CthHostAllocator.hpp"
+#include "vulkan/utility/CthVkUtils.hpp"
+
+#include <cth/cth_log.hpp>
+
+#include <algorithm>
+#include <format>
+#include <numeric>
+#include <span>
+
+
+
+namespace cth {
+GpuProfiler::Scope GpuProfiler::scope(const string_view name) {
+    lock_guard lock{profilerMutex};
+
+    const auto it = ranges::find(histories, name, &History::name);
+    if(it != histories.end()) return static_cast<Scope>(distance(histories.begin(), it));
+
+    histories.push_back(History{string(name)});
+    return static_cast<Scope>(histories.size() - 1);
+}
+
+void GpuProfiler::beginFrame(VkCommandBuffer command_buffer, const uint32_t frame_index) {
+    if(!enabled) return;
+
+    CTH_ERR(frame_index >= frames.size(), "frame index out of range") throw details->exception();
+
+    lock_guard lock{profilerMutex};
+    currentFrame = frame_index;
+    Frame& frame = frames[currentFrame];
+
+    resolve(frame);
+    vkCmdResetQueryPool(command_buffer, frame.pool, 0, MAX_QUERIES_PER_FRAME);
+}
+GpuProfiler::Query GpuProfiler::begin(VkCommandBuffer command_buffer, const Scope scope) {
+    if(!enabled) return INVALID_QUERY;
+
+    Query query;
+    VkQueryPool pool;
+    {
+        lock_guard lock{profilerMutex};
+        CTH_ERR(scope >= histories.size(), "unknown scope") throw details->exception();
+
+        Frame& frame = frames[currentFrame];
+        if(frame.scopes.size() * 2 >= MAX_QUERIES_PER_FRAME) return INVALID_QUERY;
+
+        query = static_cast<Query>(frame.scopes.size() * 2);
+        pool = frame.pool;
+        frame.scopes.push_back(scope);
+    }
+
+    vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, pool, query);
+    return query;
+}
+void GpuProfiler::end(VkCommandBuffer command_buffer, const Query query) const {
+    if(query == INVALID_QUERY) return;
+
+    VkQueryPool pool;
+    {
+        lock_guard lock{profilerMutex};
+        pool = frames[currentFrame].pool;
+    }
+
+    vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, pool, query + 1);
+}
+
+GpuProfiler::Stats GpuProfiler::stats(const Scope scope) const {
+    lock_guard lock{profilerMutex};
+    CTH_ERR(scope >= histories.size(), "unknown scope") throw details->exception();
+
+    const History& history = histories[scope];
+    if(history.count == 0) return Stats{};
+
+    const span<const double> samples{history.samples.data(), history.count};
+    const auto [min, max] = ranges::minmax(samples);
+    const double last = history.samples[(history.next + HISTORY_SIZE - 1) % HISTORY_SIZE];
+
+    return Stats{last, min, accumulate(samples.begin(), samples.end(), 0.0) / history.count, max, history.count};
+}
+string GpuProfiler::report() const {
+    string result = format("gpu profile over the last {} frames\n", HISTORY_SIZE);
+
+    size_t scopeCount;
+    {
+        lock_guard lock{profilerMutex};
+        scopeCount = histories.size();
+    }
+
+    for(Scope i = 0; i < scopeCount; i++) {
+        const Stats scopeStats = stats(i);
+        lock_guard lock{profilerMutex};
+        result += format("\t{0}: avg {1:.3f} ms, min {2:.3f} ms, max {3:.3f} ms\n", histories[i].name, scopeStats.avgMs, scopeStats.minMs,
+            scopeStats.maxMs);
+    }
+
+    return result;
+}
+void GpuProfiler::logReport() const {
+    CTH_WARN(!enabled, "gpu timestamps not supported") return;
+    cth::log::msg<except::INFO>("{}", report());
+}
+
+uint64_t GpuProfiler::validBitsMask(const uint32_t valid_bits) { return valid_bits >= 64 ? ~0ull : (1ull << valid_bits) - 1; }
+void GpuProfiler::resolve(Frame& frame) {
+    if(frame.scopes.empty()) return;
+
+    //the slot's frame finished, the results are available without waiting
+    vector<uint64_t> timestamps(frame.scopes.size() * 2);
+    const VkResult queryResult = vkGetQueryPoolResults(device->get(), frame.pool, 0, static_cast<uint32_t>(timestamps.size()),
+        timestamps.size() * sizeof(uint64_t), timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+
+    vector<double> frameMs(histories.size(), -1.0);
+    if(queryResult == VK_SUCCESS)
+        for(size_t i = 0; i < frame.scopes.size(); i++) {
+            const uint64_t ticks = (timestamps[i * 2 + 1] - timestamps[i * 2]) & tickMask;
+            double& ms = frameMs[frame.scopes[i]];
+            ms = std::max(ms, 0.0) + static_cast<double>(ticks) * periodNs / 1e6;
+        }
+
+    CTH_WARN(queryResult != VK_SUCCESS, "gpu timestamps of the frame dropped") details->add("result: {}", static_cast<int>(queryResult));
+
+    for(Scope i = 0; i < frameMs.size(); i++) {
+        if(frameMs[i] < 0) continue;
+
+        History& history = histories[i];
+        history.samples[history.next] = frameMs[i];
+        history.next = (history.next + 1) % HISTORY_SIZE;
+        history.count = std::min(history.count + 1, HISTORY_SIZE);
+    }
+
+    frame.scopes.clear();
+}
+
+void GpuProfiler::destroyPools() {
+    ranges::for_each(frames, [this](Frame& frame) {
+        if constexpr(ResourceTracker::ENABLED)
+            if(frame.pool != VK_NULL_HANDLE) device->resourceTracker()->remove(ResourceTracker::TYPE_QUERY_POOL, frame.pool);
+        vkDestroyQueryPool(device->get(), frame.pool, HostAllocator::callbacks(HostAllocator::CATEGORY_DEVICE));
+        frame.pool = VK_NULL_HANDLE;
+    });
+}
+
+GpuProfiler::GpuProfiler(Device* device, const uint32_t frame_count) : device(device), frames(frame_count) {
+    uint32_t familyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(device->physical(), &familyCount, nullptr);
+    vector<VkQueueFamilyProperties> families(familyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(device->physical(), &familyCount, families.data());
+
+    const uint32_t validBits = families[device->queueFamilies().graphicsFamilyIndex].timestampValidBits;
+    enabled = validBits != 0 && device->limits().timestampPeriod > 0;
+
+    CTH_WARN(!enabled, "gpu timestamps not supported by the graphics queue, profiler disabled") return;
+
+    periodNs = device->limits().timestampPeriod;
+    tickMask = validBitsMask(validBits);
+
+    VkQueryPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    poolInfo.queryCount = MAX_QUERIES_PER_FRAME;
+
+    for(auto& frame : frames) {
+        const VkResult createResult = vkCreateQueryPool(device->get(), &poolInfo, HostAllocator::callbacks(HostAllocator::CATEGORY_DEVICE), &frame.pool);
+        CTH_STABLE_ERR(createResult != VK_SUCCESS, "failed to create timestamp query pool") {
+            //the destructor doesn't run for a throwing constructor
+            frame.pool = VK_NULL_HANDLE;
+            destroyPools();
+            throw cth::except::vk_result_exception{createResult, details->exception()};
+        }
+        if constexpr(ResourceTracker::ENABLED) device->resourceTracker()->add(ResourceTracker::TYPE_QUERY_POOL, frame.pool, 0, "GpuProfiler");
+    }
+}
+GpuProfiler::~GpuProfiler() { destroyPools(); }
+
+} // namespace cth
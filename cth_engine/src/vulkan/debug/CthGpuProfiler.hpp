@@ -0,0 +1,121 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace cth {
+using namespace std;
+class Device;
+
+/**
+ * \brief measures gpu time of named scopes with timestamp queries, one query pool per frame in flight
+ * \note results of a frame slot are read when the slot is reused, they arrive frames in flight frames later and never stall
+ * \note stats are rolling over the last HISTORY_SIZE frames, a scope used more than once per frame adds up its durations
+ * \note thread safe, scopes may be recorded into secondaries on other threads
+ */
+class GpuProfiler {
+public:
+    using Scope = uint32_t;
+    using Query = uint32_t;
+    static constexpr Query INVALID_QUERY = ~0u;
+
+    struct Stats {
+        double lastMs = 0; /*in milliseconds*/
+        double minMs = 0;
+        double avgMs = 0;
+        double maxMs = 0;
+        uint32_t samples = 0; /*frames in the rolling window*/
+    };
+
+    /**
+     * \return id of the scope, created on the first call with name
+     */
+    [[nodiscard]] Scope scope(string_view name);
+
+    /**
+     * \brief resolves the finished results of the frame slot and resets its queries
+     * \param command_buffer primary of the frame, outside of a render pass
+     * \note the frame that last used the slot must have finished
+     */
+    void beginFrame(VkCommandBuffer command_buffer, uint32_t frame_index);
+    /**
+     * \brief writes the start timestamp of scope
+     * \return query for end(), INVALID_QUERY if disabled or the frame ran out of queries
+     */
+    [[nodiscard]] Query begin(VkCommandBuffer command_buffer, Scope scope);
+    /**
+     * \brief writes the end timestamp, must be recorded into the same queue submission as begin()
+     */
+    void end(VkCommandBuffer command_buffer, Query query) const;
+
+    [[nodiscard]] Stats stats(Scope scope) const;
+    /**
+     * \return min/avg/max per scope
+     */
+    [[nodiscard]] string report() const;
+    void logReport() const;
+
+    static constexpr uint32_t MAX_QUERIES_PER_FRAME = 256; /*two per scope use*/
+    static constexpr uint32_t HISTORY_SIZE = 128; /*frames*/
+
+private:
+    struct Frame {
+        VkQueryPool pool = VK_NULL_HANDLE;
+        vector<Scope> scopes{}; /*[query / 2] scope of the written query pair*/
+    };
+    struct History {
+        string name;
+        array<double, HISTORY_SIZE> samples{}; /*in milliseconds*/
+        uint32_t count = 0;
+        uint32_t next = 0;
+    };
+
+    [[nodiscard]] static uint64_t validBitsMask(uint32_t valid_bits);
+    /**
+     * \note requires the profiler mutex
+     */
+    void resolve(Frame& frame);
+    /**
+     * \note skips pools that were not created
+     */
+    void destroyPools();
+
+    Device* device;
+    bool enabled = false;
+    double periodNs = 1; /*nanoseconds per tick*/
+    uint64_t tickMask = ~0ull;
+
+    vector<Frame> frames;
+    uint32_t currentFrame = 0;
+    vector<History> histories{}; /*[Scope]*/
+    mutable mutex profilerMutex{};
+
+public:
+    /**
+     * \param frame_count frames in flight
+     * \throws cth::except::vk_result_exception result of vkCreateQueryPool()
+     */
+    GpuProfiler(Device* device, uint32_t frame_count);
+    /**
+     * \note the queries must not be pending anymore
+     */
+    ~GpuProfiler();
+
+    /**
+     * \return false if the graphics queue doesn't support timestamps, every call is a no op
+     */
+    [[nodiscard]] bool supported() const { return enabled; }
+
+    GpuProfiler(const GpuProfiler& other) = delete;
+    GpuProfiler(GpuProfiler&& other) = delete;
+    GpuProfiler& operator=(const GpuProfiler& other) = delete;
+    GpuProfiler& operator=(GpuProfiler&& other) = delete;
+};
+
+} // namespace cth
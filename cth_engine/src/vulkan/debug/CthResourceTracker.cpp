@@ -0,0 +1,99 @@
+#include "CthResourceTracker.hpp"
+
+#include "vulkan/utility/CthVkUtils.hpp"
+
+#include <cth/cth_log.hpp>
+
+#include <algorithm>
+#include <format>
+
+
+
+namespace cth {
+ResourceTracker::Usage ResourceTracker::usage(const Resource_Type type) const {
+    lock_guard lock{trackerMutex};
+    return usages[type];
+}
+vector<ResourceTracker::Entry> ResourceTracker::live() const {
+    lock_guard lock{trackerMutex};
+
+    vector<Entry> liveEntries{};
+    for(const auto& typeEntries : entries)
+        for(const auto& entry : typeEntries | views::values) liveEntries.push_back(entry);
+
+    ranges::sort(liveEntries, {}, &Entry::created);
+    return liveEntries;
+}
+string ResourceTracker::report() const {
+    const auto now = chrono::steady_clock::now();
+    const vector<Entry> liveEntries = live();
+
+    string result = format("resource report after {} ms\n", chrono::duration_cast<chrono::milliseconds>(now - startTime).count());
+
+    for(uint32_t i = 0; i < TYPES_SIZE; i++) {
+        const auto type = static_cast<Resource_Type>(i);
+        const Usage typeUsage = usage(type);
+        result += format("\t{0}: {1} live ({2} bytes), peak {3} ({4} bytes)\n", typeName(type), typeUsage.count, typeUsage.bytes,
+            typeUsage.peakCount, typeUsage.peakBytes);
+    }
+
+    if(liveEntries.empty()) return result;
+
+    result += format("live resources: {}\n", liveEntries.size());
+    for(const auto& [type, handle, size, tag, created] : liveEntries)
+        result += format("\t[{0}] {1:#x} {2} bytes, tag: {3}, age: {4} ms\n", typeName(type), handle, size, tag,
+            chrono::duration_cast<chrono::milliseconds>(now - created).count());
+
+    return result;
+}
+void ResourceTracker::logReport() const {
+    const bool leaks = !live().empty();
+
+    CTH_WARN(leaks, "live resources at report") details->add("{}", report());
+    if(!leaks) cth::log::msg<except::INFO>("{}", report());
+}
+
+void ResourceTracker::addEntry(const Resource_Type type, const uint64_t handle, const VkDeviceSize size, const string_view tag) {
+    lock_guard lock{trackerMutex};
+
+    const auto [it, inserted] = entries[type].try_emplace(handle, Entry{type, handle, size, string(tag), chrono::steady_clock::now()});
+    CTH_ERR(!inserted, "resource tracked twice") {
+        details->add("type: {0}, handle: {1:#x}, tag: {2}", typeName(type), handle, tag);
+        throw details->exception();
+    }
+
+    Usage& typeUsage = usages[type];
+    ++typeUsage.count;
+    typeUsage.bytes += size;
+    typeUsage.peakCount = std::max(typeUsage.peakCount, typeUsage.count);
+    typeUsage.peakBytes = std::max(typeUsage.peakBytes, typeUsage.bytes);
+}
+void ResourceTracker::removeEntry(const Resource_Type type, const uint64_t handle) {
+    lock_guard lock{trackerMutex};
+
+    //called from destructors, must not throw
+    const auto it = entries[type].find(handle);
+    CTH_WARN(it == entries[type].end(), "resource was not tracked") {
+        details->add("type: {0}, handle: {1:#x}", typeName(type), handle);
+        return;
+    }
+
+    Usage& typeUsage = usages[type];
+    --typeUsage.count;
+    typeUsage.bytes -= it->second.size;
+
+    entries[type].erase(it);
+}
+void ResourceTracker::labelEntry(const Resource_Type type, const uint64_t handle, const string_view tag) {
+    lock_guard lock{trackerMutex};
+
+    const auto it = entries[type].find(handle);
+    CTH_ERR(it == entries[type].end(), "resource was not tracked") {
+        details->add("type: {0}, handle: {1:#x}", typeName(type), handle);
+        throw details->exception();
+    }
+
+    it->second.tag = tag;
+}
+
+} // namespace cth
@@ -0,0 +1,126 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+
+namespace cth {
+using namespace std;
+
+/**
+ * \brief records live vulkan objects and memory blocks with a tag, size and creation time
+ * \note objects without own memory are tracked with size 0, objects retired by the deletion queue are removed when it destroys them
+ * \note descriptor sets and command buffers are not tracked, they are freed with their pool, fences are not used by the engine
+ * \note compiled out unless CTH_TRACK_RESOURCES is defined, guard every call with if constexpr(ResourceTracker::ENABLED)
+ * \note thread safe
+ */
+class ResourceTracker {
+public:
+    static constexpr bool ENABLED = []() {
+#ifdef CTH_TRACK_RESOURCES
+        return true;
+#else
+        return false;
+#endif
+    }();
+
+    enum Resource_Type : uint32_t {
+        TYPE_MEMORY,
+        TYPE_BUFFER,
+        TYPE_IMAGE,
+        TYPE_SHADER,
+        TYPE_IMAGE_VIEW,
+        TYPE_SAMPLER,
+        TYPE_PIPELINE,
+        TYPE_DESCRIPTOR_POOL,
+        TYPE_FRAMEBUFFER,
+        TYPE_RENDER_PASS,
+        TYPE_SEMAPHORE,
+        TYPE_QUERY_POOL,
+        TYPE_COMMAND_POOL,
+        TYPES_SIZE
+    };
+
+    struct Entry {
+        Resource_Type type;
+        uint64_t handle;
+        VkDeviceSize size; /*in bytes*/
+        string tag; /*creating subsystem or user label*/
+        chrono::steady_clock::time_point created;
+    };
+    struct Usage {
+        uint32_t count = 0;
+        VkDeviceSize bytes = 0; /*in bytes*/
+        uint32_t peakCount = 0;
+        VkDeviceSize peakBytes = 0; /*in bytes*/
+    };
+
+    /**
+     * \param size in bytes
+     * \param tag creating subsystem or user label
+     */
+    template<typename T>
+    void add(Resource_Type type, T handle, VkDeviceSize size, string_view tag) { addEntry(type, handleId(handle), size, tag); }
+    template<typename T>
+    void remove(Resource_Type type, T handle) { removeEntry(type, handleId(handle)); }
+    /**
+     * \brief replaces the tag of a live resource
+     */
+    template<typename T>
+    void label(Resource_Type type, T handle, string_view tag) { labelEntry(type, handleId(handle), tag); }
+
+    [[nodiscard]] Usage usage(Resource_Type type) const;
+    /**
+     * \return live resources sorted by creation time
+     */
+    [[nodiscard]] vector<Entry> live() const;
+    /**
+     * \return usage and high water marks per type followed by every live resource
+     */
+    [[nodiscard]] string report() const;
+    /**
+     * \brief logs the report, warns if resources are alive
+     */
+    void logReport() const;
+
+    [[nodiscard]] static constexpr string_view typeName(const Resource_Type type) {
+        constexpr array<string_view, TYPES_SIZE> names{"memory", "buffer", "image", "shader", "image view", "sampler", "pipeline",
+            "descriptor pool", "framebuffer", "render pass", "semaphore", "query pool", "command pool"};
+        return type < TYPES_SIZE ? names[type] : "unknown";
+    }
+
+private:
+    void addEntry(Resource_Type type, uint64_t handle, VkDeviceSize size, string_view tag);
+    void removeEntry(Resource_Type type, uint64_t handle);
+    void labelEntry(Resource_Type type, uint64_t handle, string_view tag);
+
+    template<typename T>
+    [[nodiscard]] static uint64_t handleId(T handle) {
+        //non dispatchable handles are pointers on 64 bit and integers on 32 bit platforms
+        if constexpr(is_pointer_v<T>) return reinterpret_cast<uint64_t>(handle);
+        else return static_cast<uint64_t>(handle);
+    }
+
+    array<unordered_map<uint64_t, Entry>, TYPES_SIZE> entries{};
+    array<Usage, TYPES_SIZE> usages{};
+    chrono::steady_clock::time_point startTime = chrono::steady_clock::now();
+    mutable mutex trackerMutex{};
+
+public:
+    ResourceTracker() = default;
+    ~ResourceTracker() = default;
+
+    ResourceTracker(const ResourceTracker& other) = delete;
+    ResourceTracker(ResourceTracker&& other) = delete;
+    ResourceTracker& operator=(const ResourceTracker& other) = delete;
+    ResourceTracker& operator=(ResourceTracker&& other) = delete;
+};
+
+} // namespace cth
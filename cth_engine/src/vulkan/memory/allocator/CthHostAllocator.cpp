@@ -0,0 +1,284 @@
+#include "CthHostAllocator.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <format>
+#include <limits>
+#include <mutex>
+#include <new>
+
+
+
+namespace cth {
+namespace {
+    constexpr size_t SIZE_CLASS_COUNT = HostAllocator::SIZE_CLASSES.size();
+    constexpr uint16_t LARGE_CLASS = numeric_limits<uint16_t>::max();
+    constexpr size_t SCOPES_SIZE = VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE + 1;
+
+    /**
+     * \brief precedes every allocation
+     */
+    struct Header {
+        uint64_t size; /*requested size in bytes*/
+        uint16_t sizeClass; /*LARGE_CLASS -> allocated with operator new*/
+        uint8_t category;
+        uint8_t scope;
+        uint32_t offset; /*offset of the user memory from the start of a large allocation, equals its alignment*/
+    };
+    static_assert(sizeof(Header) == HostAllocator::POOL_ALIGNMENT, "the header must keep pool slots aligned");
+
+    struct FreeSlot {
+        FreeSlot* next;
+    };
+
+    struct Pool {
+        mutex poolMutex{};
+        FreeSlot* head = nullptr;
+    };
+
+    struct AtomicStats {
+        atomic<size_t> bytes{0};
+        atomic<size_t> peakBytes{0};
+        atomic<size_t> allocations{0};
+        atomic<size_t> totalAllocations{0};
+        atomic<size_t> internalBytes{0};
+    };
+
+    array<Pool, SIZE_CLASS_COUNT> pools{};
+    array<AtomicStats, HostAllocator::CATEGORIES_SIZE> categoryStats{};
+    array<AtomicStats, SCOPES_SIZE> scopeStats{};
+
+
+    constexpr size_t slotSize(const size_t size_class) { return sizeof(Header) + HostAllocator::SIZE_CLASSES[size_class]; }
+    uint16_t sizeClass(const size_t size) {
+        return static_cast<uint16_t>(ranges::lower_bound(HostAllocator::SIZE_CLASSES, size) - HostAllocator::SIZE_CLASSES.begin());
+    }
+
+    /**
+     * \brief splits a new page into slots and pushes them to the pool
+     * \note pages are never released, the pools only grow to the peak usage
+     * \note requires the pool mutex
+     */
+    bool carvePage(Pool& pool, const size_t size_class) {
+        const auto page = static_cast<char*>(::operator new(HostAllocator::PAGE_SIZE, align_val_t{HostAllocator::POOL_ALIGNMENT}, nothrow));
+        if(page == nullptr) return false;
+
+        const size_t size = slotSize(size_class);
+        for(size_t offset = 0; offset + size <= HostAllocator::PAGE_SIZE; offset += size) {
+            const auto slot = reinterpret_cast<FreeSlot*>(page + offset);
+            slot->next = pool.head;
+            pool.head = slot;
+        }
+        return true;
+    }
+
+    struct ThreadCache {
+        array<FreeSlot*, SIZE_CLASS_COUNT> heads{};
+        array<size_t, SIZE_CLASS_COUNT> counts{};
+
+        /**
+         * \brief moves count slots back to the pool
+         */
+        void flush(const size_t size_class, size_t count) {
+            Pool& pool = pools[size_class];
+            lock_guard lock{pool.poolMutex};
+
+            for(; count > 0 && heads[size_class] != nullptr; --count) {
+                FreeSlot* slot = heads[size_class];
+                heads[size_class] = slot->next;
+                slot->next = pool.head;
+                pool.head = slot;
+                --counts[size_class];
+            }
+        }
+        /**
+         * \brief moves half of the cache capacity from the pool into the cache
+         * \return false if the pool is empty and a new page could not be allocated
+         */
+        bool refill(const size_t size_class) {
+            Pool& pool = pools[size_class];
+            lock_guard lock{pool.poolMutex};
+
+            if(pool.head == nullptr && !carvePage(pool, size_class)) return false;
+
+            for(size_t i = 0; i < HostAllocator::MAX_CACHED_SLOTS / 2 && pool.head != nullptr; i++) {
+                FreeSlot* slot = pool.head;
+                pool.head = slot->next;
+                slot->next = heads[size_class];
+                heads[size_class] = slot;
+                ++counts[size_class];
+            }
+            return true;
+        }
+
+        [[nodiscard]] void* pop(const size_t size_class) {
+            if(heads[size_class] == nullptr && !refill(size_class)) return nullptr;
+
+            FreeSlot* slot = heads[size_class];
+            heads[size_class] = slot->next;
+            --counts[size_class];
+            return slot;
+        }
+        void push(const size_t size_class, void* memory) {
+            const auto slot = static_cast<FreeSlot*>(memory);
+            slot->next = heads[size_class];
+            heads[size_class] = slot;
+
+            if(++counts[size_class] > HostAllocator::MAX_CACHED_SLOTS) flush(size_class, HostAllocator::MAX_CACHED_SLOTS / 2);
+        }
+
+        ~ThreadCache() {
+            for(size_t i = 0; i < SIZE_CLASS_COUNT; i++) flush(i, counts[i]);
+        }
+    };
+
+    thread_local ThreadCache threadCache{};
+
+
+    void addBytes(AtomicStats& stats, const size_t size) {
+        const size_t bytes = stats.bytes.fetch_add(size, memory_order_relaxed) + size;
+
+        size_t peak = stats.peakBytes.load(memory_order_relaxed);
+        while(peak < bytes && !stats.peakBytes.compare_exchange_weak(peak, bytes, memory_order_relaxed)) {}
+    }
+    void recordAllocation(const Header& header) {
+        for(AtomicStats* stats : {&categoryStats[header.category], &scopeStats[header.scope]}) {
+            addBytes(*stats, header.size);
+            stats->allocations.fetch_add(1, memory_order_relaxed);
+            stats->totalAllocations.fetch_add(1, memory_order_relaxed);
+        }
+    }
+    void recordFree(const Header& header) {
+        for(AtomicStats* stats : {&categoryStats[header.category], &scopeStats[header.scope]}) {
+            stats->bytes.fetch_sub(header.size, memory_order_relaxed);
+            stats->allocations.fetch_sub(1, memory_order_relaxed);
+        }
+    }
+    HostAllocator::Stats load(const AtomicStats& stats) {
+        return HostAllocator::Stats{stats.bytes.load(memory_order_relaxed), stats.peakBytes.load(memory_order_relaxed),
+            stats.allocations.load(memory_order_relaxed), stats.totalAllocations.load(memory_order_relaxed),
+            stats.internalBytes.load(memory_order_relaxed)};
+    }
+}
+
+
+
+const VkAllocationCallbacks* HostAllocator::callbacks(const Category category) {
+    static const array<VkAllocationCallbacks, CATEGORIES_SIZE> allocationCallbacks = []() {
+        array<VkAllocationCallbacks, CATEGORIES_SIZE> result{};
+        for(uint32_t i = 0; i < CATEGORIES_SIZE; i++) {
+            result[i].pUserData = reinterpret_cast<void*>(static_cast<uintptr_t>(i));
+            result[i].pfnAllocation = &allocate;
+            result[i].pfnReallocation = &reallocate;
+            result[i].pfnFree = &free;
+            result[i].pfnInternalAllocation = &internalAllocation;
+            result[i].pfnInternalFree = &internalFree;
+        }
+        return result;
+    }();
+
+    return &allocationCallbacks[category];
+}
+
+HostAllocator::Stats HostAllocator::stats(const Category category) { return load(categoryStats[category]); }
+HostAllocator::Stats HostAllocator::scopeStats(const VkSystemAllocationScope scope) { return load(cth::scopeStats[scope]); }
+string HostAllocator::report() {
+    constexpr array<string_view, SCOPES_SIZE> scopeNames{"command", "object", "cache", "device", "instance"};
+
+    string result = "host allocations\n";
+    for(uint32_t i = 0; i < CATEGORIES_SIZE; i++) {
+        const auto [bytes, peakBytes, allocations, totalAllocations, internalBytes] = stats(static_cast<Category>(i));
+        result += format("\t{0}: {1} bytes in {2} allocations, peak {3} bytes, total {4} allocations, internal {5} bytes\n",
+            categoryName(static_cast<Category>(i)), bytes, allocations, peakBytes, totalAllocations, internalBytes);
+    }
+    for(uint32_t i = 0; i < SCOPES_SIZE; i++) {
+        const auto [bytes, peakBytes, allocations, totalAllocations, internalBytes] = scopeStats(static_cast<VkSystemAllocationScope>(i));
+        result += format("\tscope {0}: {1} bytes in {2} allocations, peak {3} bytes, total {4} allocations, internal {5} bytes\n",
+            scopeNames[i], bytes, allocations, peakBytes, totalAllocations, internalBytes);
+    }
+    return result;
+}
+
+void* HostAllocator::allocate(void* user_data, const size_t size, const size_t alignment, const VkSystemAllocationScope scope) {
+    if(size == 0) return nullptr;
+
+    Header* header = nullptr;
+
+    if(alignment <= POOL_ALIGNMENT && size <= SIZE_CLASSES.back()) {
+        const uint16_t sizeClass = cth::sizeClass(size);
+        header = static_cast<Header*>(threadCache.pop(sizeClass));
+        if(header == nullptr) return nullptr;
+
+        header->sizeClass = sizeClass;
+        header->offset = 0;
+    } else {
+        //the header fits into the alignment padding in front of the user memory
+        const size_t offset = std::max(alignment, POOL_ALIGNMENT);
+        const auto base = static_cast<char*>(::operator new(offset + size, align_val_t{offset}, nothrow));
+        if(base == nullptr) return nullptr;
+
+        header = reinterpret_cast<Header*>(base + offset) - 1;
+        header->sizeClass = LARGE_CLASS;
+        header->offset = static_cast<uint32_t>(offset);
+    }
+
+    header->size = size;
+    header->category = static_cast<uint8_t>(reinterpret_cast<uintptr_t>(user_data));
+    header->scope = static_cast<uint8_t>(scope);
+    recordAllocation(*header);
+
+    return header + 1;
+}
+void* HostAllocator::reallocate(void* user_data, void* original, const size_t size, const size_t alignment,
+    const VkSystemAllocationScope scope) {
+    if(original == nullptr) return allocate(user_data, size, alignment, scope);
+    if(size == 0) {
+        free(user_data, original);
+        return nullptr;
+    }
+
+    Header* header = static_cast<Header*>(original) - 1;
+
+    //shrinking or growing inside of the slot keeps the memory
+    if(header->sizeClass != LARGE_CLASS && alignment <= POOL_ALIGNMENT && size <= SIZE_CLASSES[header->sizeClass]) {
+        for(AtomicStats* stats : {&categoryStats[header->category], &cth::scopeStats[header->scope]}) {
+            stats->bytes.fetch_sub(header->size, memory_order_relaxed);
+            addBytes(*stats, size);
+        }
+        header->size = size;
+        return original;
+    }
+
+    void* memory = allocate(user_data, size, alignment, scope);
+    if(memory == nullptr) return nullptr;
+
+    memcpy(memory, original, std::min(static_cast<size_t>(header->size), size));
+    free(user_data, original);
+
+    return memory;
+}
+void HostAllocator::free(void*, void* memory) {
+    if(memory == nullptr) return;
+
+    Header* header = static_cast<Header*>(memory) - 1;
+    recordFree(*header);
+
+    if(header->sizeClass == LARGE_CLASS) {
+        const size_t offset = header->offset;
+        ::operator delete(static_cast<char*>(memory) - offset, align_val_t{offset});
+        return;
+    }
+
+    threadCache.push(header->sizeClass, header);
+}
+void HostAllocator::internalAllocation(void* user_data, const size_t size, VkInternalAllocationType, const VkSystemAllocationScope scope) {
+    categoryStats[reinterpret_cast<uintptr_t>(user_data)].internalBytes.fetch_add(size, memory_order_relaxed);
+    cth::scopeStats[scope].internalBytes.fetch_add(size, memory_order_relaxed);
+}
+void HostAllocator::internalFree(void* user_data, const size_t size, VkInternalAllocationType, const VkSystemAllocationScope scope) {
+    categoryStats[reinterpret_cast<uintptr_t>(user_data)].internalBytes.fetch_sub(size, memory_order_relaxed);
+    cth::scopeStats[scope].internalBytes.fetch_sub(size, memory_order_relaxed);
+}
+
+} // namespace cth
@@ -0,0 +1,72 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <cstddef>
+#include <string>
+
+
+namespace cth {
+using namespace std;
+
+/**
+ * \brief VkAllocationCallbacks for driver host allocations
+ * \note small allocations come from size class pools with a cache per thread, large ones from aligned operator new
+ * \note every category gets its own callbacks, allocations are counted per category and per VkSystemAllocationScope
+ * \note all callbacks are compatible, objects may be destroyed with the callbacks of another category
+ * \note thread safe
+ */
+class HostAllocator {
+public:
+    enum Category : uint32_t {
+        CATEGORY_INSTANCE,
+        CATEGORY_DEVICE,
+        CATEGORY_SWAPCHAIN,
+        CATEGORY_RESOURCE,
+        CATEGORY_PIPELINE,
+        CATEGORY_DESCRIPTOR,
+        CATEGORIES_SIZE
+    };
+
+    struct Stats {
+        size_t bytes = 0; /*live bytes*/
+        size_t peakBytes = 0;
+        size_t allocations = 0; /*live allocations*/
+        size_t totalAllocations = 0;
+        size_t internalBytes = 0; /*live bytes the driver allocated without the callbacks*/
+    };
+
+    /**
+     * \return callbacks to pass as pAllocator, valid for the lifetime of the program
+     */
+    [[nodiscard]] static const VkAllocationCallbacks* callbacks(Category category);
+
+    [[nodiscard]] static Stats stats(Category category);
+    [[nodiscard]] static Stats scopeStats(VkSystemAllocationScope scope);
+    /**
+     * \return stats per category and per scope
+     */
+    [[nodiscard]] static string report();
+
+    [[nodiscard]] static constexpr string_view categoryName(const Category category) {
+        constexpr array<string_view, CATEGORIES_SIZE> names{"instance", "device", "swapchain", "resource", "pipeline", "descriptor"};
+        return category < CATEGORIES_SIZE ? names[category] : "unknown";
+    }
+
+    static constexpr array<size_t, 8> SIZE_CLASSES{16, 32, 64, 128, 256, 512, 1024, 2048};
+    static constexpr size_t POOL_ALIGNMENT = 16; /*larger alignments bypass the pools*/
+    static constexpr size_t PAGE_SIZE = 64ull * 1024;
+    static constexpr size_t MAX_CACHED_SLOTS = 64; /*per thread and size class, half is returned to the pool on overflow*/
+
+private:
+    static void* VKAPI_CALL allocate(void* user_data, size_t size, size_t alignment, VkSystemAllocationScope scope);
+    static void* VKAPI_CALL reallocate(void* user_data, void* original, size_t size, size_t alignment, VkSystemAllocationScope scope);
+    static void VKAPI_CALL free(void* user_data, void* memory);
+    static void VKAPI_CALL internalAllocation(void* user_data, size_t size, VkInternalAllocationType type, VkSystemAllocationScope scope);
+    static void VKAPI_CALL internalFree(void* user_data, size_t size, VkInternalAllocationType type, VkSystemAllocationScope scope);
+
+public:
+    HostAllocator() = delete;
+};
+
+} // namespace cth
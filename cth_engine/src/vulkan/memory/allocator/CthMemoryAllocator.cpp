@@ -0,0 +1,246 @@
+#include "CthMemoryAllocator.hpp"
+
+#include "CthHostAllocator.hpp"
+
+#include "vulkan/base/CthDevice.hpp"
+#include "vulkan/debug/CthResourceTracker.hpp"
+#include "vulkan/utility/CthVkUtils.hpp"
+
+#include <cth/cth_log.hpp>
+
+#include <algorithm>
+
+
+
+//MemoryBlock
+
+namespace cth {
+optional<VkDeviceSize> MemoryBlock::allocate(const VkDeviceSize size, const VkDeviceSize alignment) {
+    for(auto it = freeRanges.begin(); it != freeRanges.end(); ++it) {
+        const VkDeviceSize alignedOffset = MemoryAllocator::align(it->offset, alignment);
+        const VkDeviceSize padding = alignedOffset - it->offset;
+        if(it->size < padding + size) continue;
+
+        const Range front{it->offset, padding};
+        const Range back{alignedOffset + size, it->size - padding - size};
+
+        if(back.size > 0) *it = back;
+        else it = freeRanges.erase(it);
+        if(front.size > 0) freeRanges.insert(it, front);
+
+        usedSize += size;
+        ++allocations;
+        return alignedOffset;
+    }
+    return nullopt;
+}
+void MemoryBlock::free(const VkDeviceSize offset, const VkDeviceSize size) {
+    CTH_ERR(offset + size > blockSize, "range out of bounds") throw details->exception();
+
+    auto it = ranges::lower_bound(freeRanges, offset, {}, &Range::offset);
+    it = freeRanges.insert(it, Range{offset, size});
+
+    if(const auto next = it + 1; next != freeRanges.end() && it->offset + it->size == next->offset) {
+        it->size += next->size;
+        freeRanges.erase(next);
+    }
+    if(it != freeRanges.begin()) {
+        const auto prev = it - 1;
+        if(prev->offset + prev->size == it->offset) {
+            prev->size += it->size;
+            freeRanges.erase(it);
+        }
+    }
+
+    usedSize -= size;
+    --allocations;
+}
+
+MemoryBlock::MemoryBlock(Device* device, const uint32_t memory_type_index, const VkDeviceSize size, const bool host_visible,
+    const bool dedicated) : device(device), typeIndex(memory_type_index), blockSize(size), _dedicated(dedicated) {
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = blockSize;
+    allocInfo.memoryTypeIndex = typeIndex;
+
+    const VkResult allocResult = vkAllocateMemory(device->get(), &allocInfo, HostAllocator::callbacks(HostAllocator::CATEGORY_RESOURCE), &vkMemory);
+    CTH_STABLE_ERR(allocResult != VK_SUCCESS, "failed to allocate memory block") {
+        details->add("size: {} bytes, memory type: {}", blockSize, typeIndex);
+        throw cth::except::vk_result_exception{allocResult, details->exception()};
+    }
+
+    if(host_visible) {
+        void* mappedMemory = nullptr;
+        const VkResult mapResult = vkMapMemory(device->get(), vkMemory, 0, VK_WHOLE_SIZE, 0, &mappedMemory);
+        CTH_STABLE_ERR(mapResult != VK_SUCCESS, "Vk: memory block mapping failed") {
+            vkFreeMemory(device->get(), vkMemory, HostAllocator::callbacks(HostAllocator::CATEGORY_RESOURCE));
+            throw cth::except::vk_result_exception{mapResult, details->exception()};
+        }
+        mappedPtr = static_cast<char*>(mappedMemory);
+    }
+
+    freeRanges.push_back(Range{0, blockSize});
+
+    if constexpr(ResourceTracker::ENABLED)
+        device->resourceTracker()->add(ResourceTracker::TYPE_MEMORY, vkMemory, blockSize, dedicated ? "MemoryAllocator dedicated" : "MemoryAllocator");
+}
+MemoryBlock::~MemoryBlock() {
+    if constexpr(ResourceTracker::ENABLED) device->resourceTracker()->remove(ResourceTracker::TYPE_MEMORY, vkMemory);
+
+    if(mappedPtr != nullptr) vkUnmapMemory(device->get(), vkMemory);
+    vkFreeMemory(device->get(), vkMemory, HostAllocator::callbacks(HostAllocator::CATEGORY_RESOURCE));
+}
+
+} // namespace cth
+
+
+
+//MemoryAllocator
+
+namespace cth {
+MemoryAllocation MemoryAllocator::allocate(const VkMemoryRequirements& requirements, const VkMemoryPropertyFlags properties, const bool linear,
+    const VkMemoryPropertyFlags preferred, const VkMemoryPropertyFlags not_preferred) {
+    const uint32_t typeIndex = device->findMemoryType(requirements.memoryTypeBits, properties, preferred, not_preferred);
+
+    VkDeviceSize size = requirements.size;
+    VkDeviceSize alignment = requirements.alignment;
+
+    //non coherent ranges must be flushable without touching neighbouring allocations
+    if(hostVisible(typeIndex) && !hostCoherent(typeIndex)) {
+        const VkDeviceSize atomSize = device->limits().nonCoherentAtomSize;
+        alignment = std::max(alignment, atomSize);
+        size = align(size, atomSize);
+    }
+
+    const VkDeviceSize preferredBlockSize = blockSize(typeIndex);
+
+    lock_guard lock{allocMutex};
+    auto& blocks = pool(typeIndex, linear).blocks;
+
+    MemoryBlock* block = nullptr;
+    optional<VkDeviceSize> offset = nullopt;
+
+    if(size <= preferredBlockSize / 2)
+        for(const auto& poolBlock : blocks) {
+            if(poolBlock->dedicated()) continue;
+            offset = poolBlock->allocate(size, alignment);
+            if(offset == nullopt) continue;
+
+            block = poolBlock.get();
+            break;
+        }
+
+    if(block == nullptr) {
+        const bool dedicated = size > preferredBlockSize / 2;
+        blocks.push_back(make_unique<MemoryBlock>(device, typeIndex, dedicated ? size : preferredBlockSize, hostVisible(typeIndex), dedicated));
+        block = blocks.back().get();
+        offset = block->allocate(size, alignment);
+    }
+
+    MemoryAllocation allocation{};
+    allocation.memory = block->get();
+    allocation.offset = *offset;
+    allocation.size = size;
+    allocation.memoryTypeIndex = typeIndex;
+    allocation.mapped = block->mapped() == nullptr ? nullptr : block->mapped() + *offset;
+    allocation.block = block;
+
+    return allocation;
+}
+void MemoryAllocator::free(MemoryAllocation& allocation) {
+    if(!allocation.valid()) return;
+    CTH_ERR(allocation.block == nullptr, "allocation was not created by an allocator") throw details->exception();
+
+    lock_guard lock{allocMutex};
+
+    MemoryBlock* block = allocation.block;
+    block->free(allocation.offset, allocation.size);
+
+    if(block->empty()) {
+        for(const bool linear : {false, true}) {
+            auto& blocks = pool(block->memoryTypeIndex(), linear).blocks;
+            const auto it = ranges::find_if(blocks, [block](const unique_ptr<MemoryBlock>& pool_block) { return pool_block.get() == block; });
+            if(it == blocks.end()) continue;
+
+            //keep one empty block per pool to avoid reallocating on alloc/free cycles
+            const bool otherEmpty = ranges::any_of(blocks, [block](const unique_ptr<MemoryBlock>& pool_block) {
+                return pool_block.get() != block && !pool_block->dedicated() && pool_block->empty();
+            });
+
+            if(block->dedicated() || otherEmpty) blocks.erase(it);
+            break;
+        }
+    }
+
+    allocation = MemoryAllocation{};
+}
+
+MemoryStats MemoryAllocator::stats() const {
+    const auto& memoryProperties = device->memoryProperties();
+
+    MemoryStats stats{};
+    stats.heaps.resize(memoryProperties.memoryHeapCount);
+    stats.types.resize(memoryProperties.memoryTypeCount);
+
+    for(uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++) {
+        stats.heaps[i].flags = memoryProperties.memoryHeaps[i].flags;
+        stats.heaps[i].size = memoryProperties.memoryHeaps[i].size;
+    }
+
+    lock_guard lock{allocMutex};
+
+    for(uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+        MemoryStats::Type& type = stats.types[i];
+        type.propertyFlags = memoryProperties.memoryTypes[i].propertyFlags;
+        type.heapIndex = memoryProperties.memoryTypes[i].heapIndex;
+
+        for(const bool linear : {false, true})
+            for(const auto& block : pools[i * 2 + (linear ? 1 : 0)].blocks) {
+                ++type.blockCount;
+                type.blockBytes += block->size();
+                type.allocationCount += block->allocationCount();
+                type.usedBytes += block->used();
+                type.largestBlock = std::max(type.largestBlock, block->size());
+            }
+
+        MemoryStats::Heap& heap = stats.heaps[type.heapIndex];
+        heap.blockCount += type.blockCount;
+        heap.blockBytes += type.blockBytes;
+        heap.allocationCount += type.allocationCount;
+        heap.usedBytes += type.usedBytes;
+        heap.largestBlock = std::max(heap.largestBlock, type.largestBlock);
+    }
+
+    for(auto& heap : stats.heaps) {
+        heap.usage = heap.blockBytes;
+        heap.budget = heap.size;
+    }
+
+    return stats;
+}
+
+VkDeviceSize MemoryAllocator::blockSize(const uint32_t memory_type_index) const {
+    const auto& memoryProperties = device->memoryProperties();
+    const uint32_t heapIndex = memoryProperties.memoryTypes[memory_type_index].heapIndex;
+    const VkDeviceSize heapSize = memoryProperties.memoryHeaps[heapIndex].size;
+
+    return std::min(DEFAULT_BLOCK_SIZE, heapSize / 8);
+}
+bool MemoryAllocator::hostVisible(const uint32_t memory_type_index) const {
+    return device->memoryProperties().memoryTypes[memory_type_index].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+}
+bool MemoryAllocator::hostCoherent(const uint32_t memory_type_index) const {
+    return device->memoryProperties().memoryTypes[memory_type_index].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+}
+
+MemoryAllocator::MemoryAllocator(Device* device) : device(device) {}
+MemoryAllocator::~MemoryAllocator() {
+    for(const auto& [blocks] : pools)
+        for(const auto& block : blocks)
+            CTH_WARN(!block->empty(), "memory block destroyed with live allocations") {
+                details->add("memory type: {}", block->memoryTypeIndex());
+                details->add("allocations: {0}, used: {1} bytes", block->allocationCount(), block->used());
+            }
+}
+
+} // namespace cth
@@ -0,0 +1,167 @@
+#pragma once
+#include "CthMemoryStats.hpp"
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+
+namespace cth {
+using namespace std;
+class Device;
+class MemoryBlock;
+
+/**
+ * \brief suballocated range of a VkDeviceMemory block
+ */
+struct MemoryAllocation {
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0; /*offset inside memory in bytes*/
+    VkDeviceSize size = 0; /*size in bytes*/
+    uint32_t memoryTypeIndex = 0;
+    char* mapped = nullptr; /*persistent mapping of the range, nullptr -> not host visible*/
+
+    [[nodiscard]] bool valid() const { return memory != VK_NULL_HANDLE; }
+
+private:
+    MemoryBlock* block = nullptr;
+
+    friend class MemoryAllocator;
+};
+
+/**
+ * \brief single VkDeviceMemory page, suballocated first fit from a sorted free list
+ * \note host visible blocks stay mapped for their whole lifetime
+ */
+class MemoryBlock {
+public:
+    /**
+     * \param size in bytes
+     * \param alignment in bytes
+     * \return offset of the range in bytes, nullopt -> no free range large enough
+     */
+    [[nodiscard]] optional<VkDeviceSize> allocate(VkDeviceSize size, VkDeviceSize alignment);
+    /**
+     * \brief returns the range to the free list and merges it with adjacent ranges
+     * \param offset in bytes
+     * \param size in bytes
+     */
+    void free(VkDeviceSize offset, VkDeviceSize size);
+
+private:
+    struct Range {
+        VkDeviceSize offset;
+        VkDeviceSize size;
+    };
+
+    Device* device;
+    VkDeviceMemory vkMemory = VK_NULL_HANDLE;
+    char* mappedPtr = nullptr;
+
+    uint32_t typeIndex;
+    VkDeviceSize blockSize;
+    bool _dedicated;
+
+    vector<Range> freeRanges{};
+    VkDeviceSize usedSize = 0;
+    uint32_t allocations = 0;
+
+public:
+    /**
+     * \param size in bytes
+     * \param dedicated block is released once its allocation is freed
+     * \throws cth::except::vk_result_exception result of vkAllocateMemory()
+     * \throws cth::except::vk_result_exception result of vkMapMemory()
+     */
+    MemoryBlock(Device* device, uint32_t memory_type_index, VkDeviceSize size, bool host_visible, bool dedicated);
+    ~MemoryBlock();
+
+    [[nodiscard]] VkDeviceMemory get() const { return vkMemory; }
+    [[nodiscard]] char* mapped() const { return mappedPtr; }
+    [[nodiscard]] uint32_t memoryTypeIndex() const { return typeIndex; }
+    [[nodiscard]] VkDeviceSize size() const { return blockSize; }
+    [[nodiscard]] VkDeviceSize used() const { return usedSize; }
+    [[nodiscard]] uint32_t allocationCount() const { return allocations; }
+    [[nodiscard]] bool empty() const { return allocations == 0; }
+    [[nodiscard]] bool dedicated() const { return _dedicated; }
+
+    MemoryBlock(const MemoryBlock& other) = delete;
+    MemoryBlock(MemoryBlock&& other) = delete;
+    MemoryBlock& operator=(const MemoryBlock& other) = delete;
+    MemoryBlock& operator=(MemoryBlock&& other) = delete;
+};
+
+/**
+ * \brief suballocates buffers and images from large VkDeviceMemory blocks per memory type
+ * \note linear (buffers) and optimal (images) resources use separate blocks to avoid bufferImageGranularity conflicts
+ * \note thread safe
+ */
+class MemoryAllocator {
+public:
+    /**
+     * \param properties required memory property flags
+     * \param linear true for buffers and linear tiled images, false for optimal tiled images
+     * \param preferred memory property flags the memory type should have
+     * \param not_preferred memory property flags the memory type should not have
+     * \throws cth::except::default_exception reason: no suitable memory type
+     * \throws cth::except::vk_result_exception result of vkAllocateMemory()
+     * \throws cth::except::vk_result_exception result of vkMapMemory()
+     */
+    [[nodiscard]] MemoryAllocation allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, bool linear,
+        VkMemoryPropertyFlags preferred = 0, VkMemoryPropertyFlags not_preferred = 0);
+    /**
+     * \brief returns the range to its block and releases empty surplus blocks
+     * \note resets the allocation
+     */
+    void free(MemoryAllocation& allocation);
+
+    /**
+     * \brief collects block and allocation counts per memory type and per heap
+     * \note usage and budget are set to the allocators block bytes and the heap size
+     */
+    [[nodiscard]] MemoryStats stats() const;
+
+    /**
+     * \param value in bytes
+     * \param alignment in bytes, must be > 0
+     * \return value rounded up to the next multiple of alignment
+     */
+    [[nodiscard]] static constexpr VkDeviceSize align(const VkDeviceSize value, const VkDeviceSize alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64ull * 1024 * 1024;
+
+private:
+    struct Pool {
+        vector<unique_ptr<MemoryBlock>> blocks{};
+    };
+
+    /**
+     * \return preferred block size of the memory types heap
+     */
+    [[nodiscard]] VkDeviceSize blockSize(uint32_t memory_type_index) const;
+    [[nodiscard]] Pool& pool(uint32_t memory_type_index, bool linear) { return pools[memory_type_index * 2 + (linear ? 1 : 0)]; }
+    [[nodiscard]] bool hostVisible(uint32_t memory_type_index) const;
+    [[nodiscard]] bool hostCoherent(uint32_t memory_type_index) const;
+
+    Device* device;
+
+    array<Pool, VK_MAX_MEMORY_TYPES * 2> pools{};
+    mutable mutex allocMutex{};
+
+public:
+    explicit MemoryAllocator(Device* device);
+    ~MemoryAllocator();
+
+    MemoryAllocator(const MemoryAllocator& other) = delete;
+    MemoryAllocator(MemoryAllocator&& other) = delete;
+    MemoryAllocator& operator=(const MemoryAllocator& other) = delete;
+    MemoryAllocator& operator=(MemoryAllocator&& other) = delete;
+};
+
+} // namespace cth
@@ -0,0 +1,43 @@
+#include "CthMemoryStats.hpp"
+
+#include <format>
+#include <numeric>
+
+
+
+namespace cth {
+VkDeviceSize MemoryStats::totalBlockBytes() const {
+    return accumulate(heaps.begin(), heaps.end(), VkDeviceSize{0}, [](const VkDeviceSize sum, const Heap& heap) { return sum + heap.blockBytes; });
+}
+VkDeviceSize MemoryStats::totalUsedBytes() const {
+    return accumulate(heaps.begin(), heaps.end(), VkDeviceSize{0}, [](const VkDeviceSize sum, const Heap& heap) { return sum + heap.usedBytes; });
+}
+uint32_t MemoryStats::totalAllocationCount() const {
+    return accumulate(heaps.begin(), heaps.end(), 0u, [](const uint32_t sum, const Heap& heap) { return sum + heap.allocationCount; });
+}
+
+string MemoryStats::json() const {
+    string result = format(R"({{"budgetAvailable":{0},"blockBytes":{1},"usedBytes":{2},"allocationCount":{3},"heaps":[)",
+        budgetAvailable, totalBlockBytes(), totalUsedBytes(), totalAllocationCount());
+
+    for(size_t i = 0; i < heaps.size(); i++) {
+        const Heap& heap = heaps[i];
+        result += format(R"({0}{{"index":{1},"flags":{2},"size":{3},"blockCount":{4},"blockBytes":{5},"allocationCount":{6},)"
+            R"("usedBytes":{7},"largestBlock":{8},"usage":{9},"budget":{10}}})", i == 0 ? "" : ",", i, heap.flags, heap.size,
+            heap.blockCount, heap.blockBytes, heap.allocationCount, heap.usedBytes, heap.largestBlock, heap.usage, heap.budget);
+    }
+
+    result += R"(],"types":[)";
+
+    for(size_t i = 0; i < types.size(); i++) {
+        const Type& type = types[i];
+        result += format(R"({0}{{"index":{1},"heapIndex":{2},"propertyFlags":{3},"blockCount":{4},"blockBytes":{5},)"
+            R"("allocationCount":{6},"usedBytes":{7},"largestBlock":{8}}})", i == 0 ? "" : ",", i, type.heapIndex, type.propertyFlags,
+            type.blockCount, type.blockBytes, type.allocationCount, type.usedBytes, type.largestBlock);
+    }
+
+    result += "]}";
+    return result;
+}
+
+} // namespace cth
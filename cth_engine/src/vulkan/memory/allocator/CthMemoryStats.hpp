@@ -0,0 +1,55 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+namespace cth {
+using namespace std;
+
+/**
+ * \brief snapshot of the device memory usage per memory type and per heap
+ * \note block bytes are the bytes allocated from vulkan, used bytes are the bytes suballocated from those blocks
+ */
+struct MemoryStats {
+    struct Type {
+        VkMemoryPropertyFlags propertyFlags;
+        uint32_t heapIndex;
+
+        uint32_t blockCount = 0;
+        VkDeviceSize blockBytes = 0; /*in bytes*/
+        uint32_t allocationCount = 0;
+        VkDeviceSize usedBytes = 0; /*in bytes*/
+        VkDeviceSize largestBlock = 0; /*in bytes*/
+    };
+    struct Heap {
+        VkMemoryHeapFlags flags;
+        VkDeviceSize size; /*in bytes*/
+
+        uint32_t blockCount = 0;
+        VkDeviceSize blockBytes = 0; /*in bytes*/
+        uint32_t allocationCount = 0;
+        VkDeviceSize usedBytes = 0; /*in bytes*/
+        VkDeviceSize largestBlock = 0; /*in bytes*/
+
+        VkDeviceSize usage = 0; /*usage of the whole process in bytes, block bytes if the budget is not available*/
+        VkDeviceSize budget = 0; /*in bytes, heap size if the budget is not available*/
+    };
+
+    vector<Type> types{};
+    vector<Heap> heaps{};
+    bool budgetAvailable = false; /*usage and budget are reported by VK_EXT_memory_budget*/
+
+    [[nodiscard]] VkDeviceSize totalBlockBytes() const;
+    [[nodiscard]] VkDeviceSize totalUsedBytes() const;
+    [[nodiscard]] uint32_t totalAllocationCount() const;
+
+    /**
+     * \return stats as a json object with a "heaps" and a "types" array
+     */
+    [[nodiscard]] string json() const;
+};
+
+} // namespace cth
@@ -17,28 +17,31 @@ public:
     * \param offset in elements
     * \return mapped memory range
     * \note use map without arguments for whole buffer mapping
+    * \note FLAG_PERSISTENT_MAP -> subspan of the persistent mapping, no vulkan call
     */
     [[nodiscard]] span<T> map(VkDeviceSize size, VkDeviceSize offset);
     /**
     * \return mapped memory of whole buffer
+    * \note FLAG_PERSISTENT_MAP -> may be called repeatedly
     */
     span<T> map();
 
     /**
-     * \brief stages a device local buffer with a temporary host visible buffer
+     * \brief stages a device local buffer through the devices upload queue
      * \param buffer_offset in elements
+     * \note does not wait for the copy, later submits on the graphics queue see the data once the upload queue was submitted
      */
     void stage(span<T> data, VkDeviceSize buffer_offset = 0) const;
 
     /**
-     * \brief writes to a mapped memory range
+     * \brief writes to a mapped memory range and marks it dirty
      */
-    void write(span<T> data, span<T> mapped_memory, VkDeviceSize mapped_offset = 0) const;
+    void write(span<T> data, span<T> mapped_memory, VkDeviceSize mapped_offset = 0);
     /**
-    * \brief writes to the mapped range of the whole buffer
+    * \brief writes to the mapped range of the whole buffer and marks it dirty
     * \note CAUTION whole buffer must be mapped first
     */
-    void write(span<T> data, VkDeviceSize mapped_offset = 0) const;
+    void write(span<T> data, VkDeviceSize mapped_offset = 0);
 
     /**
     * \brief updates non-coherent host visible memory
@@ -68,12 +71,25 @@ public:
     void copyFromBuffer(const Buffer<T>& src, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize src_offset = 0, VkDeviceSize dst_offset = 0) const;
     /**
      * \brief copies data from one buffer to another on the gpu
-     * \param size in bytes, VK_WHOLE_SIZE -> whole buffer
-     * \param src_offset in bytes
-     * \param dst_offset in bytes
+     * \param size in elements, VK_WHOLE_SIZE -> whole buffer
+     * \param src_offset in elements
+     * \param dst_offset in elements
      */
     static void copyBuffer(const Buffer<T>* src, const Buffer<T>* dst, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize src_offset = 0,
         VkDeviceSize dst_offset = 0);
+    /**
+     * \brief copies multiple regions from one buffer to another with a single vkCmdCopyBuffer()
+     * \param regions offsets and sizes in elements
+     * \param command_buffer VK_NULL_HANDLE -> recorded into the devices upload queue
+     */
+    void copyFromBuffer(const Buffer<T>& src, span<const VkBufferCopy> regions, VkCommandBuffer command_buffer = VK_NULL_HANDLE) const;
+    /**
+     * \brief copies multiple regions from one buffer to another with a single vkCmdCopyBuffer()
+     * \param regions offsets and sizes in elements
+     * \param command_buffer VK_NULL_HANDLE -> recorded into the devices upload queue
+     */
+    static void copyBuffer(const Buffer<T>* src, const Buffer<T>* dst, span<const VkBufferCopy> regions,
+        VkCommandBuffer command_buffer = VK_NULL_HANDLE);
 
 private:
     VkDeviceSize elements;
@@ -81,9 +97,10 @@ private:
 public:
     /**
      * \param min_offset_alignment in bytes
+     * \param create_flags combination of DefaultBuffer::Create_Flags
      */
     Buffer(Device* device, VkDeviceSize element_count, VkBufferUsageFlags usage_flags,
-        VkMemoryPropertyFlags memory_property_flags, VkDeviceSize min_offset_alignment = 1);
+        VkMemoryPropertyFlags memory_property_flags, VkDeviceSize min_offset_alignment = 1, uint32_t create_flags = FLAG_NONE);
     ~Buffer() override = default;
 
     [[nodiscard]] uint32_t elementCount() const { return elements; }
@@ -4,6 +4,8 @@
 
 #include <cth/cth_log.hpp>
 
+#include <algorithm>
+
 
 
 namespace cth {
@@ -11,23 +13,23 @@ namespace cth {
 template<typename T>
 span<T> Buffer<T>::map(const VkDeviceSize size, const VkDeviceSize offset) {
     const auto charSpan = DefaultBuffer::default_map(size * sizeof(T), offset * sizeof(T));
-    return span<T>{static_cast<T*>(charSpan.data()), size};
+    return span<T>{reinterpret_cast<T*>(charSpan.data()), size};
 }
 template<typename T> span<T> Buffer<T>::map() {
     const auto charSpan = default_map();
-    return span<T>{static_cast<T*>(charSpan.data()), elements};
+    return span<T>{reinterpret_cast<T*>(charSpan.data()), elements};
 }
 template<typename T>
 void Buffer<T>::stage(span<T> data, const VkDeviceSize buffer_offset) const {
     default_stage(span<char>{reinterpret_cast<char*>(data.data()), data.size() * sizeof(T)}, buffer_offset * sizeof(T));
 }
 template<typename T>
-void Buffer<T>::write(span<T> data, span<T> mapped_memory, const VkDeviceSize mapped_offset) const {
+void Buffer<T>::write(span<T> data, span<T> mapped_memory, const VkDeviceSize mapped_offset) {
     const auto charData = span<char>{reinterpret_cast<char*>(data.data()), data.size() * sizeof(T)};
     const auto charMapped = span<char>{reinterpret_cast<char*>(mapped_memory.data()), mapped_memory.size() * sizeof(T)};
     default_write(charData, charMapped, mapped_offset * sizeof(T));
 }
-template<typename T> void Buffer<T>::write(span<T> data, const VkDeviceSize mapped_offset) const {
+template<typename T> void Buffer<T>::write(span<T> data, const VkDeviceSize mapped_offset) {
     const auto charData = span<char>{reinterpret_cast<char*>(data.data()), data.size() * sizeof(T)};
     default_write(charData, mapped_offset * sizeof(T));
 }
@@ -46,20 +48,27 @@ VkResult Buffer<T>::invalidate(const VkDeviceSize size, const VkDeviceSize offse
 }
 template<typename T>
 void Buffer<T>::copyFromBuffer(const Buffer<T>& src, const VkDeviceSize size, const VkDeviceSize src_offset, const VkDeviceSize dst_offset) const {
-    const auto srcBuffer = static_cast<DefaultBuffer*>(&src);
-    const auto dstBuffer = static_cast<DefaultBuffer*>(this);
-
-    DefaultBuffer::copyFromBuffer(srcBuffer, dstBuffer, size * sizeof(T), src_offset * sizeof(T), dst_offset * sizeof(T));
+    const VkDeviceSize byteSize = size == VK_WHOLE_SIZE ? VK_WHOLE_SIZE : size * sizeof(T);
+    DefaultBuffer::copyFromBuffer(&src, byteSize, src_offset * sizeof(T), dst_offset * sizeof(T));
 }
 template<typename T> void Buffer<T>::copyBuffer(const Buffer<T>* src, const Buffer<T>* dst, const VkDeviceSize size, const VkDeviceSize src_offset,
     const VkDeviceSize dst_offset) {
-    const auto srcBuffer = static_cast<DefaultBuffer*>(&src);
-    const auto dstBuffer = static_cast<DefaultBuffer*>(&dst);
-
-    DefaultBuffer::copyBuffer(srcBuffer, dstBuffer, size * sizeof(T), src_offset * sizeof(T), dst_offset * sizeof(T));
+    const VkDeviceSize byteSize = size == VK_WHOLE_SIZE ? VK_WHOLE_SIZE : size * sizeof(T);
+    DefaultBuffer::copyBuffer(src, dst, byteSize, src_offset * sizeof(T), dst_offset * sizeof(T));
+}
+template<typename T>
+void Buffer<T>::copyFromBuffer(const Buffer<T>& src, const span<const VkBufferCopy> regions, VkCommandBuffer command_buffer) const {
+    copyBuffer(&src, this, regions, command_buffer);
+}
+template<typename T> void Buffer<T>::copyBuffer(const Buffer<T>* src, const Buffer<T>* dst, const span<const VkBufferCopy> regions,
+    VkCommandBuffer command_buffer) {
+    vector<VkBufferCopy> byteRegions(regions.size());
+    ranges::transform(regions, byteRegions.begin(), [](const VkBufferCopy& region) {
+        return VkBufferCopy{region.srcOffset * sizeof(T), region.dstOffset * sizeof(T), region.size * sizeof(T)};
+    });
+    DefaultBuffer::copyBuffer(src, dst, byteRegions, command_buffer);
 }
 template<typename T> Buffer<T>::Buffer(Device* device, const VkDeviceSize element_count, const VkBufferUsageFlags usage_flags,
-    const VkMemoryPropertyFlags memory_property_flags, const VkDeviceSize min_offset_alignment) : DefaultBuffer(device, element_count * sizeof(T),
-    usage_flags, memory_property_flags,
-    min_offset_alignment), elements(element_count) {}
+    const VkMemoryPropertyFlags memory_property_flags, const VkDeviceSize min_offset_alignment, const uint32_t create_flags) : DefaultBuffer(device,
+    element_count * sizeof(T), usage_flags, memory_property_flags, min_offset_alignment, create_flags), elements(element_count) {}
 } // namespace cth
@@ -1,75 +1,103 @@
 #include "CthDefaultBuffer.hpp"
 
+#include "vulkan/base/CthDeletionQueue.hpp"
 #include "vulkan/base/CthDevice.hpp"
+#include "vulkan/debug/CthResourceTracker.hpp"
+#include "vulkan/memory/transfer/CthUploadQueue.hpp"
 #include "vulkan/utility/CthVkUtils.hpp"
 
+#include <algorithm>
+#include <iterator>
+
 
 namespace cth {
 
     VkDeviceSize DefaultBuffer::calcAlignedSize(const VkDeviceSize actual_size, const VkDeviceSize min_offset_alignment) {
-        if(min_offset_alignment > 0) return actual_size + (min_offset_alignment - actual_size % min_offset_alignment);
+        if(min_offset_alignment > 0) return MemoryAllocator::align(actual_size, min_offset_alignment);
         return actual_size;
     }
     span<char> DefaultBuffer::default_map(const VkDeviceSize size, const VkDeviceSize offset) {
-        CTH_ERR(!vkBuffer || !vkMemory, "buffer not created yet") throw details->exception();
+        CTH_ERR(!vkBuffer || !memory.valid(), "buffer not created yet") throw details->exception();
         CTH_ERR(size + offset > bufferSize - padding, "memory out of bounds")
             throw details->exception();
+        CTH_ERR(memory.mapped == nullptr, "buffer memory is not host visible") throw details->exception();
 
-        void* mappedPtr = nullptr;
-        const VkResult mapResult = vkMapMemory(device->get(), vkMemory, offset, size, 0, &mappedPtr);
-        CTH_STABLE_ERR(mapResult != VK_SUCCESS, "Vk: memory mapping failed")
-            throw except::vk_result_exception{mapResult, details->exception()};
-
-        return span<char>{static_cast<char*>(mappedPtr), size};
+        if(persistentlyMapped()) return mapped.subspan(offset, size);
+        return span<char>{memory.mapped + offset, size};
     }
     span<char> DefaultBuffer::default_map() {
-        CTH_ERR(mapped.data(), "buffer already mapped") throw details->exception();
-        CTH_ERR(!vkBuffer || !vkMemory, "buffer not created yet") throw details->exception();
+        if(persistentlyMapped()) return mapped;
 
-        void* mappedPtr = nullptr;
-        const VkResult mapResult = vkMapMemory(device->get(), vkMemory, 0, VK_WHOLE_SIZE, 0, &mappedPtr);
-        CTH_STABLE_ERR(mapResult != VK_SUCCESS, "Vk: memory mapping failed")
-            throw except::vk_result_exception{mapResult, details->exception()};
+        CTH_ERR(mapped.data(), "buffer already mapped") throw details->exception();
+        CTH_ERR(!vkBuffer || !memory.valid(), "buffer not created yet") throw details->exception();
+        CTH_ERR(memory.mapped == nullptr, "buffer memory is not host visible") throw details->exception();
 
-        mapped = span<char>(static_cast<char*>(mappedPtr), bufferSize - padding);
+        mapped = span<char>(memory.mapped, bufferSize - padding);
         return mapped;
     }
 
     void DefaultBuffer::unmap() {
-        if(!mapped.data()) return;
+        if(!mapped.data() || persistentlyMapped()) return;
 
-        vkUnmapMemory(device->get(), vkMemory);
         mapped = span<char>();
     }
 
     void DefaultBuffer::default_stage(const span<char> data, const VkDeviceSize buffer_offset) const {
-        const unique_ptr<DefaultBuffer> stagingBuffer = make_unique<DefaultBuffer>(device, data.size(),
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-            VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-        stagingBuffer->default_map();
-        stagingBuffer->default_write(data);
+        CTH_ERR(!(vkUsageFlags & VK_BUFFER_USAGE_TRANSFER_DST_BIT), "buffer usage must be marked as transfer destination")
+            throw details->exception();
+        CTH_ERR(buffer_offset + data.size() > bufferSize, "stage operation out of bounds") throw details->exception();
 
-        copyFromBuffer(stagingBuffer.get(), stagingBuffer->bufferSize, 0, buffer_offset);
+        device->uploadQueue()->stage(data, vkBuffer, buffer_offset);
     }
 
-    void DefaultBuffer::default_write(const span<char> data, const span<char> mapped_memory, const VkDeviceSize mapped_offset) const {
+    void DefaultBuffer::default_write(const span<char> data, const span<char> mapped_memory, const VkDeviceSize mapped_offset) {
+        CTH_ERR(mapped_offset + data.size() > mapped_memory.size(), "write out of mapped range") throw details->exception();
+
         memcpy(mapped_memory.data() + mapped_offset, data.data(), data.size());
+
+        if(memory.mapped != nullptr) markDirty(data.size(), static_cast<VkDeviceSize>(mapped_memory.data() - memory.mapped) + mapped_offset);
     }
-    void DefaultBuffer::default_write(const span<char> data, const VkDeviceSize mapped_offset) const {
+    void DefaultBuffer::default_write(const span<char> data, const VkDeviceSize mapped_offset) {
         CTH_ERR(!mapped.data(), "mapped_memory invalid or buffer was not mapped entirely")
             throw details->exception();
 
         memcpy(mapped.data() + mapped_offset, data.data(), data.size());
+        markDirty(data.size(), mapped_offset);
+    }
+
+    void DefaultBuffer::markDirty(const VkDeviceSize size, const VkDeviceSize offset) {
+        CTH_ERR(offset + size > bufferSize, "dirty range out of bounds") throw details->exception();
+        if(size == 0 || hostCoherent()) return;
+
+        auto it = ranges::upper_bound(dirtyRanges, offset, {}, &Range::offset);
+
+        //merge into the previous range if it touches
+        if(it != dirtyRanges.begin() && (it - 1)->offset + (it - 1)->size >= offset) {
+            --it;
+            it->size = std::max(it->offset + it->size, offset + size) - it->offset;
+        } else it = dirtyRanges.insert(it, Range{offset, size});
+
+        //absorb the following ranges that touch
+        auto next = it + 1;
+        for(; next != dirtyRanges.end() && next->offset <= it->offset + it->size; ++next)
+            it->size = std::max(it->offset + it->size, next->offset + next->size) - it->offset;
+        dirtyRanges.erase(it + 1, next);
+    }
+    VkResult DefaultBuffer::flushDirty() {
+        if(dirtyRanges.empty()) return VK_SUCCESS;
+
+        const auto memoryRanges = mappedRanges(dirtyRanges);
+        const VkResult result = vkFlushMappedMemoryRanges(device->get(), static_cast<uint32_t>(memoryRanges.size()), memoryRanges.data());
+
+        if(result == VK_SUCCESS) dirtyRanges.clear();
+        return result;
     }
 
     VkResult DefaultBuffer::flush(const VkDeviceSize size, const VkDeviceSize offset) const {
-        VkMappedMemoryRange mappedRange = {};
-        mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-        mappedRange.memory = vkMemory;
-        mappedRange.offset = offset;
-        mappedRange.size = size;
-        return vkFlushMappedMemoryRanges(device->get(), 1, &mappedRange);
+        if(hostCoherent()) return VK_SUCCESS;
+
+        const VkMappedMemoryRange memoryRange = mappedRange(size, offset);
+        return vkFlushMappedMemoryRanges(device->get(), 1, &memoryRange);
     }
 
     Descriptor::descriptor_info_t DefaultBuffer::descriptorInfo(const VkDeviceSize size, const VkDeviceSize offset) const {
@@ -77,12 +105,16 @@ namespace cth {
     }
 
     VkResult DefaultBuffer::invalidate(const VkDeviceSize size, const VkDeviceSize offset) const {
-        VkMappedMemoryRange mappedRange = {};
-        mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-        mappedRange.memory = vkMemory;
-        mappedRange.offset = offset;
-        mappedRange.size = size;
-        return vkInvalidateMappedMemoryRanges(device->get(), 1, &mappedRange);
+        if(hostCoherent()) return VK_SUCCESS;
+
+        const VkMappedMemoryRange memoryRange = mappedRange(size, offset);
+        return vkInvalidateMappedMemoryRanges(device->get(), 1, &memoryRange);
+    }
+    VkResult DefaultBuffer::invalidateRanges(const span<const Range> buffer_ranges) const {
+        if(buffer_ranges.empty() || hostCoherent()) return VK_SUCCESS;
+
+        const auto memoryRanges = mappedRanges(buffer_ranges);
+        return vkInvalidateMappedMemoryRanges(device->get(), static_cast<uint32_t>(memoryRanges.size()), memoryRanges.data());
     }
     void DefaultBuffer::copyFromBuffer(const DefaultBuffer* src, const VkDeviceSize size, const VkDeviceSize src_offset,
         const VkDeviceSize dst_offset) const {
@@ -112,18 +144,108 @@ namespace cth {
 
         src->device->copyBuffer(src->vkBuffer, dst->vkBuffer, copySize, src_offset, dst_offset);
     }
+    void DefaultBuffer::copyFromBuffer(const DefaultBuffer* src, const span<const VkBufferCopy> regions, VkCommandBuffer command_buffer) const {
+        copyBuffer(src, this, regions, command_buffer);
+    }
+    void DefaultBuffer::copyBuffer(const DefaultBuffer* src, const DefaultBuffer* dst, const span<const VkBufferCopy> regions,
+        VkCommandBuffer command_buffer) {
+        CTH_ERR(!(src->usageFlags() & VK_BUFFER_USAGE_TRANSFER_SRC_BIT), "src buffer usage must be marked as transfer source")
+            throw details->exception();
+        CTH_ERR(!(dst->usageFlags() & VK_BUFFER_USAGE_TRANSFER_DST_BIT), "dst buffer usage must be marked as transfer destination")
+            throw details->exception();
+
+        const vector<VkBufferCopy> copyRegions = coalesce(regions);
+        if(copyRegions.empty()) return;
+
+        for(const auto& [srcOffset, dstOffset, size] : copyRegions) {
+            CTH_ERR(srcOffset + size > src->bufferSize || dstOffset + size > dst->bufferSize, "copy region out of bounds") {
+                details->add("src: {0} + {1} (buffer size: {2})", srcOffset, size, src->bufferSize);
+                details->add("dst: {0} + {1} (buffer size: {2})", dstOffset, size, dst->bufferSize);
+                throw details->exception();
+            }
+        }
+
+        if(command_buffer == VK_NULL_HANDLE) src->device->copyBuffer(src->vkBuffer, dst->vkBuffer, copyRegions);
+        else vkCmdCopyBuffer(command_buffer, src->vkBuffer, dst->vkBuffer, static_cast<uint32_t>(copyRegions.size()), copyRegions.data());
+    }
+    vector<VkBufferCopy> DefaultBuffer::coalesce(const span<const VkBufferCopy> regions) {
+        vector<VkBufferCopy> sorted{};
+        sorted.reserve(regions.size());
+        ranges::copy_if(regions, back_inserter(sorted), [](const VkBufferCopy& region) { return region.size > 0; });
+        ranges::sort(sorted, {}, &VkBufferCopy::dstOffset);
+
+        vector<VkBufferCopy> merged{};
+        merged.reserve(sorted.size());
+        for(const VkBufferCopy& region : sorted) {
+            if(!merged.empty()) {
+                VkBufferCopy& last = merged.back();
+                if(last.dstOffset + last.size == region.dstOffset && last.srcOffset + last.size == region.srcOffset) {
+                    last.size += region.size;
+                    continue;
+                }
+            }
+            merged.push_back(region);
+        }
+
+        return merged;
+    }
+
+    bool DefaultBuffer::hostCoherent() const {
+        //the allocator may pick a coherent type for a non-coherent request, only non-coherent allocations are atom aligned
+        return device->memoryProperties().memoryTypes[memory.memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    }
+    VkMappedMemoryRange DefaultBuffer::mappedRange(const VkDeviceSize size, const VkDeviceSize offset) const {
+        const VkDeviceSize atomSize = device->limits().nonCoherentAtomSize;
+
+        //the allocation is atom aligned for non-coherent memory, expanding stays inside of it
+        const VkDeviceSize begin = memory.offset + offset / atomSize * atomSize;
+        const VkDeviceSize end = size == VK_WHOLE_SIZE ? memory.offset + memory.size :
+            std::min(memory.offset + MemoryAllocator::align(offset + size, atomSize), memory.offset + memory.size);
+
+        VkMappedMemoryRange memoryRange = {};
+        memoryRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+        memoryRange.memory = memory.memory;
+        memoryRange.offset = begin;
+        memoryRange.size = end - begin;
+        return memoryRange;
+    }
+    vector<VkMappedMemoryRange> DefaultBuffer::mappedRanges(const span<const Range> buffer_ranges) const {
+        vector<VkMappedMemoryRange> memoryRanges{};
+        memoryRanges.reserve(buffer_ranges.size());
+
+        for(const auto& [offset, size] : buffer_ranges) {
+            const VkMappedMemoryRange memoryRange = mappedRange(size, offset);
+
+            //ranges may overlap after expanding to the atom size
+            if(!memoryRanges.empty() && memoryRanges.back().offset + memoryRanges.back().size >= memoryRange.offset) {
+                auto& last = memoryRanges.back();
+                last.size = std::max(last.offset + last.size, memoryRange.offset + memoryRange.size) - last.offset;
+            } else memoryRanges.push_back(memoryRange);
+        }
+
+        return memoryRanges;
+    }
 
     DefaultBuffer::DefaultBuffer(Device* device, const VkDeviceSize buffer_size, const VkBufferUsageFlags usage_flags,
-        const VkMemoryPropertyFlags memory_property_flags, const VkDeviceSize min_offset_alignment) : device(device),
-        bufferSize(calcAlignedSize(buffer_size, min_offset_alignment)), padding(buffer_size - bufferSize),
-        vkUsageFlags(usage_flags), vkMemoryPropertyFlags(memory_property_flags) {
-        device->createBuffer(bufferSize, usage_flags, memory_property_flags, vkBuffer, vkMemory);
+        const VkMemoryPropertyFlags memory_property_flags, const VkDeviceSize min_offset_alignment, const uint32_t create_flags) :
+        device(device), bufferSize(calcAlignedSize(buffer_size, min_offset_alignment)), padding(bufferSize - buffer_size),
+        vkUsageFlags(usage_flags), vkMemoryPropertyFlags(memory_property_flags), createFlags(create_flags) {
+        CTH_ERR(persistentlyMapped() && !(memory_property_flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT),
+            "persistent mapping requires host visible memory") throw details->exception();
+
+        device->createBuffer(bufferSize, usage_flags, memory_property_flags, vkBuffer, memory);
+
+        if(persistentlyMapped()) mapped = span<char>(memory.mapped, bufferSize - padding);
+
+        if constexpr(ResourceTracker::ENABLED) device->resourceTracker()->add(ResourceTracker::TYPE_BUFFER, vkBuffer, bufferSize, "DefaultBuffer");
     }
 
     DefaultBuffer::~DefaultBuffer() {
-        unmap();
-        vkDestroyBuffer(device->get(), vkBuffer, nullptr);
-        vkFreeMemory(device->get(), vkMemory, nullptr);
+        if constexpr(ResourceTracker::ENABLED) device->resourceTracker()->remove(ResourceTracker::TYPE_BUFFER, vkBuffer);
+
+        mapped = span<char>();
+        device->deletionQueue()->enqueue(DeletionQueue::TYPE_BUFFER, vkBuffer);
+        device->deletionQueue()->enqueue(memory);
     }
 
 
@@ -1,9 +1,11 @@
 #pragma once
+#include "vulkan/memory/allocator/CthMemoryAllocator.hpp"
 #include "vulkan/memory/descriptor/CthDescriptedResource.hpp"
 
 #include <cth/cth_log.hpp>
 
 #include <span>
+#include <vector>
 
 
 namespace cth {
@@ -12,6 +14,16 @@ class Device;
 
 class DefaultBuffer : public DescriptedResource {
 public:
+    enum Create_Flags : uint32_t {
+        FLAG_NONE = 0,
+        FLAG_PERSISTENT_MAP = 1 << 0, /*maps the whole buffer at construction, requires host visible memory*/
+    };
+
+    struct Range {
+        VkDeviceSize offset; /*in bytes*/
+        VkDeviceSize size; /*in bytes*/
+    };
+
     /**
 * \brief calculates the min size compatible with the devices minOffsetAlignment
 * \param actual_size in bytes
@@ -24,39 +36,60 @@ public:
     * \param offset in bytes
     * \return mapped memory range
     * \note use map without arguments for whole buffer mapping
+    * \note host visible memory blocks are persistently mapped, no vkMapMemory() call
+    * \note FLAG_PERSISTENT_MAP -> subspan of the persistent mapping
     */
     [[nodiscard]] virtual span<char> default_map(VkDeviceSize size, VkDeviceSize offset);
     /**
     * \return whole buffer mapped memory range
+    * \note FLAG_PERSISTENT_MAP -> may be called repeatedly, returns the persistent mapping
     */
     span<char> default_map();
 
 
     /**
-     *\brief unmaps all mapped memory ranges
+     *\brief releases the whole buffer mapping
+     *\note the underlying memory block stays mapped
+     *\note FLAG_PERSISTENT_MAP -> does nothing, the mapping lives as long as the buffer
      */
     void unmap();
 
     /**
-     * \brief stages a device local buffer with a temporary host visible buffer
+     * \brief stages a device local buffer through the devices upload queue
      * \param buffer_offset in bytes
+     * \note does not wait for the copy, later submits on the graphics queue see the data once the upload queue was submitted
      */
     void default_stage(span<char> data, VkDeviceSize buffer_offset = 0) const;
 
     /**
-     * \brief writes to a mapped memory range
+     * \brief writes to a mapped memory range and marks it dirty
+     * \param mapped_memory range returned by default_map()
      */
-    void default_write(span<char> data, span<char> mapped_memory, VkDeviceSize mapped_offset = 0) const;
+    void default_write(span<char> data, span<char> mapped_memory, VkDeviceSize mapped_offset = 0);
     /**
-     * \brief writes to the mapped range of the whole buffer
+     * \brief writes to the mapped range of the whole buffer and marks it dirty
      * \note CAUTION whole buffer must be mapped first
      */
-    void default_write(span<char> data, VkDeviceSize mapped_offset = 0) const;
+    void default_write(span<char> data, VkDeviceSize mapped_offset = 0);
+
+    /**
+     * \brief records a range written through a mapping for the next flushDirty()
+     * \param size in bytes
+     * \param offset in bytes
+     * \note merges adjacent and overlapping ranges, does nothing if the chosen memory type is host coherent
+     */
+    void markDirty(VkDeviceSize size, VkDeviceSize offset);
+    /**
+     * \brief flushes all dirty ranges with a single vkFlushMappedMemoryRanges() call
+     * \return result of vkFlushMappedMemoryRanges(), VK_SUCCESS if nothing was dirty
+     */
+    [[nodiscard]] VkResult flushDirty();
 
     /**
      * \brief updates non-coherent host visible memory
      * \param size in bytes, VK_WHOLE_SIZE -> whole buffer
      * \param offset in bytes
+     * \note the range is expanded to nonCoherentAtomSize, does nothing if the chosen memory type is host coherent
      */
     [[nodiscard]] virtual VkResult flush(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0) const;
 
@@ -67,12 +100,19 @@ public:
     [[nodiscard]] Descriptor::descriptor_info_t descriptorInfo(VkDeviceSize size, VkDeviceSize offset) const override;
 
     /**
-    * \brief
-    * \param size in elements
-    * \param offset in elements
+    * \brief makes device writes to non-coherent host visible memory visible to the host
+    * \param size in bytes, VK_WHOLE_SIZE -> whole buffer
+    * \param offset in bytes
     * \return result of vkInvalidateMappedMemoryRanges()
+    * \note the range is expanded to nonCoherentAtomSize, does nothing if the chosen memory type is host coherent
     */
     [[nodiscard]] virtual VkResult invalidate(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0) const;
+    /**
+     * \brief invalidates all ranges with a single vkInvalidateMappedMemoryRanges() call
+     * \return result of vkInvalidateMappedMemoryRanges()
+     * \note the ranges are expanded to nonCoherentAtomSize, does nothing if the chosen memory type is host coherent
+     */
+    [[nodiscard]] VkResult invalidateRanges(span<const Range> buffer_ranges) const;
 
 
     /**
@@ -89,24 +129,64 @@ public:
      * \param size in bytes, VK_WHOLE_SIZE -> whole buffer
      * \param src_offset in bytes
      * \param dst_offset in bytes
+     * \note recorded into the devices upload queue, does not wait for the copy
      */
     static void copyBuffer(const DefaultBuffer* src, const DefaultBuffer* dst, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize src_offset = 0,
         VkDeviceSize dst_offset = 0);
+    /**
+     * \brief copies multiple regions from one buffer to another with a single vkCmdCopyBuffer()
+     * \param regions offsets and sizes in bytes, coalesced before recording
+     * \param command_buffer VK_NULL_HANDLE -> recorded into the devices upload queue, else recorded into command_buffer
+     * \note with a command_buffer the caller is responsible for synchronization
+     */
+    void copyFromBuffer(const DefaultBuffer* src, span<const VkBufferCopy> regions, VkCommandBuffer command_buffer = VK_NULL_HANDLE) const;
+    /**
+     * \brief copies multiple regions from one buffer to another with a single vkCmdCopyBuffer()
+     * \param regions offsets and sizes in bytes, coalesced before recording
+     * \param command_buffer VK_NULL_HANDLE -> recorded into the devices upload queue, else recorded into command_buffer
+     * \note with a command_buffer the caller is responsible for synchronization
+     */
+    static void copyBuffer(const DefaultBuffer* src, const DefaultBuffer* dst, span<const VkBufferCopy> regions,
+        VkCommandBuffer command_buffer = VK_NULL_HANDLE);
+    /**
+     * \brief sorts regions by dst offset and merges the ones that are contiguous in src and dst
+     * \note drops empty regions
+     */
+    [[nodiscard]] static vector<VkBufferCopy> coalesce(span<const VkBufferCopy> regions);
 
 private:
+    /**
+     * \return true if the memory type the allocation landed in is host coherent, independent of the requested properties
+     */
+    [[nodiscard]] bool hostCoherent() const;
+    /**
+     * \brief expands the range to nonCoherentAtomSize and offsets it into the memory block
+     */
+    [[nodiscard]] VkMappedMemoryRange mappedRange(VkDeviceSize size, VkDeviceSize offset) const;
+    /**
+     * \brief converts ranges to atom aligned mapped ranges and merges the ones overlapping after alignment
+     */
+    [[nodiscard]] vector<VkMappedMemoryRange> mappedRanges(span<const Range> buffer_ranges) const;
+
     Device* device;
     span<char> mapped{};
+    vector<Range> dirtyRanges{}; /*sorted and disjoint*/
     VkBuffer vkBuffer = VK_NULL_HANDLE;
-    VkDeviceMemory vkMemory = VK_NULL_HANDLE;
+    MemoryAllocation memory{};
 
     VkDeviceSize bufferSize;
     VkDeviceSize padding;
     VkBufferUsageFlags vkUsageFlags;
     VkMemoryPropertyFlags vkMemoryPropertyFlags;
+    uint32_t createFlags;
 
 public:
+    /**
+     * \param min_offset_alignment in bytes
+     * \param create_flags combination of Create_Flags
+     */
     DefaultBuffer(Device* device, VkDeviceSize buffer_size, VkBufferUsageFlags usage_flags,
-        VkMemoryPropertyFlags memory_property_flags, VkDeviceSize min_offset_alignment = 1);
+        VkMemoryPropertyFlags memory_property_flags, VkDeviceSize min_offset_alignment = 1, uint32_t create_flags = FLAG_NONE);
     ~DefaultBuffer() override;
 
     [[nodiscard]] VkBuffer get() const { return vkBuffer; }
@@ -117,6 +197,8 @@ public:
     [[nodiscard]] VkBufferUsageFlags usageFlags() const { return vkUsageFlags; }
     [[nodiscard]] VkMemoryPropertyFlags memoryPropertyFlags() const { return vkMemoryPropertyFlags; }
     [[nodiscard]] VkDeviceSize size() const { return bufferSize; }
+    [[nodiscard]] bool persistentlyMapped() const { return createFlags & FLAG_PERSISTENT_MAP; }
+    [[nodiscard]] span<const Range> dirty() const { return dirtyRanges; }
 
 
     DefaultBuffer(const DefaultBuffer& other) = delete;
@@ -0,0 +1,58 @@
+#include "CthFrameAllocator.hpp"
+
+#include "CthDefaultBuffer.hpp"
+#include "vulkan/base/CthDevice.hpp"
+#include "vulkan/utility/CthVkUtils.hpp"
+
+#include <cth/cth_log.hpp>
+
+#include <algorithm>
+
+
+
+namespace cth {
+FrameAllocator::Allocation FrameAllocator::allocate(const VkDeviceSize size, const VkDeviceSize alignment) {
+    //regions are only aligned to minAlignment, larger alignments must apply to the offset in the buffer
+    const VkDeviceSize regionStart = currentRegion * regionSize;
+    const VkDeviceSize offset = MemoryAllocator::align(regionStart + head, alignment == 0 ? minAlignment : alignment) - regionStart;
+
+    CTH_STABLE_ERR(offset + size > regionSize, "frame region exhausted") {
+        details->add("requested: {0} bytes, used: {1} bytes, region size: {2} bytes", size, head, regionSize);
+        throw details->exception();
+    }
+
+    head = offset + size;
+
+    const VkDeviceSize bufferOffset = regionStart + offset;
+    return Allocation{buffer->get(), bufferOffset, mapped.subspan(bufferOffset, size)};
+}
+FrameAllocator::Allocation FrameAllocator::write(const span<const char> data, const VkDeviceSize alignment) {
+    const Allocation allocation = allocate(data.size(), alignment);
+    ranges::copy(data, allocation.memory.begin());
+    return allocation;
+}
+
+void FrameAllocator::reset(const uint32_t frame_index) {
+    CTH_ERR(frame_index >= regions, "frame index out of range") throw details->exception();
+
+    currentRegion = frame_index;
+    head = 0;
+}
+
+FrameAllocator::FrameAllocator(Device* device, const VkDeviceSize region_size, const uint32_t region_count,
+    const VkBufferUsageFlags usage_flags) : device(device), regions(region_count) {
+    const auto& limits = device->limits();
+    minAlignment = std::max({limits.minUniformBufferOffsetAlignment, limits.minStorageBufferOffsetAlignment, VkDeviceSize{16}});
+
+    //every region starts aligned so offsets stay valid dynamic offsets
+    regionSize = MemoryAllocator::align(region_size, minAlignment);
+
+    buffer = make_unique<DefaultBuffer>(device, regionSize * regions, usage_flags,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 1, DefaultBuffer::FLAG_PERSISTENT_MAP);
+    mapped = buffer->default_map();
+}
+FrameAllocator::~FrameAllocator() = default;
+
+VkBuffer FrameAllocator::get() const { return buffer->get(); }
+
+} // namespace cth
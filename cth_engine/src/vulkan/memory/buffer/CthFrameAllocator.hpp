@@ -0,0 +1,89 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <memory>
+#include <span>
+
+
+namespace cth {
+using namespace std;
+class Device;
+class DefaultBuffer;
+
+/**
+ * \brief linear allocator for per frame dynamic data, one persistently mapped buffer split into a region per frame in flight
+ * \note allocations are valid until the region of their frame is reset, reset a region once the timeline value of its frame was reached
+ * \note offsets satisfy the uniform and storage offset alignment and can be used as dynamic descriptor offsets
+ */
+class FrameAllocator {
+public:
+    struct Allocation {
+        VkBuffer buffer;
+        VkDeviceSize offset; /*offset in buffer in bytes*/
+        span<char> memory; /*mapped memory of the allocation*/
+    };
+
+    /**
+     * \brief bumps the offset of the current region
+     * \param size in bytes
+     * \param alignment in bytes, 0 -> device offset alignment, applies to the offset in the buffer
+     * \throws cth::except::default_exception reason: frame region exhausted
+     */
+    [[nodiscard]] Allocation allocate(VkDeviceSize size, VkDeviceSize alignment = 0);
+    /**
+     * \brief allocates and copies data into the allocation
+     * \throws cth::except::default_exception reason: frame region exhausted
+     */
+    Allocation write(span<const char> data, VkDeviceSize alignment = 0);
+    template<typename T>
+    Allocation write(const T& data, VkDeviceSize alignment = 0);
+
+    /**
+     * \brief makes the region of frame_index current and resets it
+     * \note the frame that last used the region must have finished
+     */
+    void reset(uint32_t frame_index);
+
+private:
+    Device* device;
+    unique_ptr<DefaultBuffer> buffer;
+    span<char> mapped{};
+
+    VkDeviceSize regionSize;
+    VkDeviceSize minAlignment;
+    uint32_t regions;
+
+    uint32_t currentRegion = 0;
+    VkDeviceSize head = 0; /*offset inside the current region in bytes*/
+
+public:
+    /**
+     * \param region_size bytes per frame in flight
+     * \param region_count frames in flight
+     * \param usage_flags buffer usage of the allocations
+     */
+    FrameAllocator(Device* device, VkDeviceSize region_size, uint32_t region_count,
+        VkBufferUsageFlags usage_flags = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+    ~FrameAllocator();
+
+    [[nodiscard]] VkBuffer get() const;
+    [[nodiscard]] DefaultBuffer* getBuffer() const { return buffer.get(); }
+    [[nodiscard]] VkDeviceSize size() const { return regionSize; }
+    [[nodiscard]] VkDeviceSize used() const { return head; }
+    [[nodiscard]] VkDeviceSize alignment() const { return minAlignment; }
+    [[nodiscard]] uint32_t regionCount() const { return regions; }
+
+    FrameAllocator(const FrameAllocator& other) = delete;
+    FrameAllocator(FrameAllocator&& other) = delete;
+    FrameAllocator& operator=(const FrameAllocator& other) = delete;
+    FrameAllocator& operator=(FrameAllocator&& other) = delete;
+};
+
+template<typename T>
+FrameAllocator::Allocation FrameAllocator::write(const T& data, const VkDeviceSize alignment) {
+    return write(span<const char>{reinterpret_cast<const char*>(&data), sizeof(T)}, alignment);
+}
+
+} // namespace cth
@@ -0,0 +1,91 @@
+#pragma once
+#include "CthBuffer.hpp"
+
+#include <memory>
+#include <span>
+
+
+namespace cth {
+using namespace std;
+class Device;
+
+/**
+ * \brief vector like buffer, reallocates with geometric growth and copies the old contents on the gpu
+ * \note host visible buffers are persistently mapped, elements are written directly and old contents are copied on the host
+ * \note device local buffers are written through the devices upload queue
+ * \note replaced buffers are handed to the devices deletion queue, which destroys them once their frames and copies finished
+ * \note get() changes on reallocation, descriptors and recorded commands referencing the old buffer must be updated
+ */
+template<typename T>
+class GrowableBuffer {
+public:
+    /**
+     * \brief reallocates if capacity is smaller than element_capacity, keeps the contents
+     * \param element_capacity in elements
+     */
+    void reserve(size_t element_capacity);
+    /**
+     * \brief sets the element count, grows geometrically if necessary
+     * \note new elements are uninitialized
+     */
+    void resize(size_t element_count);
+    /**
+     * \brief writes data behind the last element, grows geometrically if necessary
+     * \note amortized O(1) per element
+     */
+    void append(span<const T> data);
+    void append(const T& element);
+    /**
+     * \brief overwrites elements, host visible ranges are marked dirty, see DefaultBuffer::flushDirty()
+     * \param offset in elements, offset + data.size() must be <= size()
+     */
+    void write(span<const T> data, size_t offset);
+    /**
+     * \brief sets the element count to 0, keeps the capacity
+     */
+    void clear() { elements = 0; }
+
+    static constexpr size_t GROWTH_FACTOR = 2;
+    static constexpr size_t MIN_CAPACITY = 16;
+
+private:
+    /**
+     * \brief allocates a buffer with element_capacity and copies the current elements into it
+     */
+    void reallocate(size_t element_capacity);
+    [[nodiscard]] unique_ptr<Buffer<T>> createBuffer(size_t element_capacity) const;
+    [[nodiscard]] bool hostVisible() const { return memoryProperties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT; }
+
+    Device* device;
+    unique_ptr<Buffer<T>> buffer;
+
+    size_t elements = 0;
+    size_t elementCapacity = 0;
+
+    VkBufferUsageFlags usage;
+    VkMemoryPropertyFlags memoryProperties;
+
+public:
+    /**
+     * \param usage_flags transfer src and dst are added for the reallocation copies of device local memory
+     * \param initial_capacity in elements
+     */
+    GrowableBuffer(Device* device, VkBufferUsageFlags usage_flags, VkMemoryPropertyFlags memory_property_flags,
+        size_t initial_capacity = MIN_CAPACITY);
+    ~GrowableBuffer() = default;
+
+    [[nodiscard]] VkBuffer get() const { return buffer->get(); }
+    [[nodiscard]] Buffer<T>* getBuffer() const { return buffer.get(); }
+    [[nodiscard]] size_t size() const { return elements; }
+    [[nodiscard]] size_t capacity() const { return elementCapacity; }
+    [[nodiscard]] bool empty() const { return elements == 0; }
+    [[nodiscard]] VkDeviceSize byteSize() const { return elements * sizeof(T); }
+
+    GrowableBuffer(const GrowableBuffer& other) = delete;
+    GrowableBuffer(GrowableBuffer&& other) = delete;
+    GrowableBuffer& operator=(const GrowableBuffer& other) = delete;
+    GrowableBuffer& operator=(GrowableBuffer&& other) = delete;
+};
+} // namespace cth
+
+#include "CthGrowableBuffer.inl"
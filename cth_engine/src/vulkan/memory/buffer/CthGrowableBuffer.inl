@@ -0,0 +1,78 @@
+#pragma once
+#include "vulkan/base/CthDevice.hpp"
+#include "vulkan/memory/transfer/CthUploadQueue.hpp"
+
+#include <cth/cth_log.hpp>
+
+#include <algorithm>
+
+
+
+namespace cth {
+
+template<typename T>
+void GrowableBuffer<T>::reserve(const size_t element_capacity) {
+    if(element_capacity <= elementCapacity) return;
+    reallocate(element_capacity);
+}
+template<typename T>
+void GrowableBuffer<T>::resize(const size_t element_count) {
+    if(element_count > elementCapacity) reserve(std::max(elementCapacity * GROWTH_FACTOR, element_count));
+    elements = element_count;
+}
+template<typename T>
+void GrowableBuffer<T>::append(const span<const T> data) {
+    const size_t offset = elements;
+    resize(elements + data.size());
+    write(data, offset);
+}
+template<typename T> void GrowableBuffer<T>::append(const T& element) { append(span<const T>{&element, 1}); }
+template<typename T>
+void GrowableBuffer<T>::write(const span<const T> data, const size_t offset) {
+    CTH_ERR(offset + data.size() > elements, "write out of bounds") {
+        details->add("{0} + {1} > {2} (offset + data.size() > size)", offset, data.size(), elements);
+        throw details->exception();
+    }
+    if(data.empty()) return;
+
+    if(hostVisible()) {
+        ranges::copy(data, buffer->map().begin() + offset);
+        buffer->markDirty(data.size() * sizeof(T), offset * sizeof(T));
+        return;
+    }
+
+    device->uploadQueue()->stage(span<const char>{reinterpret_cast<const char*>(data.data()), data.size_bytes()}, buffer->get(),
+        offset * sizeof(T));
+}
+
+template<typename T>
+void GrowableBuffer<T>::reallocate(const size_t element_capacity) {
+    unique_ptr<Buffer<T>> newBuffer = createBuffer(element_capacity);
+
+    if(elements > 0) {
+        if(hostVisible()) {
+            ranges::copy(buffer->map().first(elements), newBuffer->map().begin());
+            newBuffer->markDirty(elements * sizeof(T), 0);
+        } else newBuffer->copyFromBuffer(*buffer, elements);
+    }
+
+    //the deletion queue keeps the old buffer alive for the frames and the recording copy using it
+    buffer = std::move(newBuffer);
+    elementCapacity = element_capacity;
+}
+template<typename T>
+unique_ptr<Buffer<T>> GrowableBuffer<T>::createBuffer(const size_t element_capacity) const {
+    const uint32_t createFlags = hostVisible() ? DefaultBuffer::FLAG_PERSISTENT_MAP : DefaultBuffer::FLAG_NONE;
+    return make_unique<Buffer<T>>(device, element_capacity, usage, memoryProperties, 1, createFlags);
+}
+
+template<typename T>
+GrowableBuffer<T>::GrowableBuffer(Device* device, const VkBufferUsageFlags usage_flags, const VkMemoryPropertyFlags memory_property_flags,
+    const size_t initial_capacity) : device(device), usage(usage_flags), memoryProperties(memory_property_flags) {
+    if(!hostVisible()) usage |= VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+    elementCapacity = std::max(initial_capacity, size_t{1});
+    buffer = createBuffer(elementCapacity);
+}
+
+} // namespace cth
@@ -0,0 +1,103 @@
+#include "CthStagingRing.hpp"
+
+#include "CthDefaultBuffer.hpp"
+#include "vulkan/base/CthDevice.hpp"
+#include "vulkan/utility/CthVkUtils.hpp"
+
+#include <cth/cth_log.hpp>
+
+#include <algorithm>
+
+
+
+namespace cth {
+optional<StagingRing::Region> StagingRing::allocate(const VkDeviceSize size, const VkDeviceSize alignment) {
+    CTH_ERR(size == 0, "size must be > 0") throw details->exception();
+
+    optional<VkDeviceSize> offset = fit(size, alignment);
+    if(offset == nullopt) {
+        const bool currentPending = ranges::any_of(batches, &Batch::currentBuffer);
+        if(capacity * 2 > MAX_CAPACITY && currentPending && size + alignment <= capacity) return nullopt;
+
+        grow(size + alignment);
+        offset = fit(size, alignment);
+    }
+
+    head = *offset + size;
+    open = true;
+
+    return Region{buffer->get(), *offset, mapped.subspan(*offset, size)};
+}
+
+void StagingRing::close(const uint64_t batch_id) {
+    CTH_ERR(!batches.empty() && batches.back().id >= batch_id, "batch ids must increase") throw details->exception();
+
+    for(auto& retired : retiredBuffers)
+        if(retired.lastBatch == nullopt) retired.lastBatch = batch_id;
+
+    if(!open) return;
+
+    batches.push_back(Batch{batch_id, head, true});
+    open = false;
+}
+void StagingRing::release(const uint64_t finished_id) {
+    while(!batches.empty() && batches.front().id <= finished_id) {
+        if(batches.front().currentBuffer) tail = batches.front().end;
+        batches.pop_front();
+    }
+
+    erase_if(retiredBuffers, [finished_id](const RetiredBuffer& retired) {
+        return retired.lastBatch != nullopt && *retired.lastBatch <= finished_id;
+    });
+
+    if(!open && ranges::none_of(batches, &Batch::currentBuffer)) head = tail = 0;
+}
+
+optional<VkDeviceSize> StagingRing::fit(const VkDeviceSize size, const VkDeviceSize alignment) const {
+    const VkDeviceSize offset = MemoryAllocator::align(head, alignment);
+
+    //used range [tail, head) is contiguous
+    if(head >= tail) {
+        if(offset + size <= capacity) return offset;
+        if(size < tail) return 0;
+        return nullopt;
+    }
+
+    //used range wraps around [tail, capacity) + [0, head)
+    if(offset + size < tail) return offset;
+    return nullopt;
+}
+void StagingRing::grow(const VkDeviceSize min_capacity) {
+    const bool currentPending = ranges::any_of(batches, &Batch::currentBuffer);
+
+    if(open || currentPending) {
+        const optional<uint64_t> lastBatch = open ? nullopt : optional{batches.back().id};
+        retiredBuffers.push_back(RetiredBuffer{std::move(buffer), lastBatch});
+        ranges::for_each(batches, [](Batch& batch) { batch.currentBuffer = false; });
+    }
+
+    VkDeviceSize newCapacity = std::max(capacity, DEFAULT_ALIGNMENT);
+    while(newCapacity < min_capacity || newCapacity <= capacity) newCapacity *= 2;
+
+    cth::log::msg<except::INFO>("growing staging ring: {0} -> {1} bytes", capacity, newCapacity);
+
+    createBuffer(newCapacity);
+}
+void StagingRing::createBuffer(const VkDeviceSize buffer_capacity) {
+    buffer = make_unique<DefaultBuffer>(device, buffer_capacity, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 1, DefaultBuffer::FLAG_PERSISTENT_MAP);
+    mapped = buffer->default_map();
+
+    capacity = buffer_capacity;
+    head = 0;
+    tail = 0;
+}
+
+StagingRing::StagingRing(Device* device, const VkDeviceSize capacity) : device(device) { createBuffer(capacity); }
+StagingRing::~StagingRing() {
+    CTH_WARN(open || !batches.empty(), "staging ring destroyed with unreleased batches") {
+        details->add("batches: {}", batches.size());
+    }
+}
+
+} // namespace cth
@@ -0,0 +1,105 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+
+
+namespace cth {
+using namespace std;
+class Device;
+class DefaultBuffer;
+
+/**
+ * \brief persistently mapped host visible ring buffer for transfer sources
+ * \note regions are grouped into batches by close() and recycled by release() once their batch finished
+ * \note grows by doubling if a request does not fit, the old buffer is released once its batches finished
+ */
+class StagingRing {
+public:
+    struct Region {
+        VkBuffer buffer;
+        VkDeviceSize offset; /*offset in buffer in bytes*/
+        span<char> memory; /*mapped memory of the region*/
+    };
+
+    /**
+     * \brief reserves a mapped region and grows the ring if necessary
+     * \param size in bytes
+     * \param alignment in bytes
+     * \return nullopt -> ring full at MAX_CAPACITY, release the oldest batch and retry
+     * \note the region is valid until its batch was released
+     */
+    [[nodiscard]] optional<Region> allocate(VkDeviceSize size, VkDeviceSize alignment = DEFAULT_ALIGNMENT);
+
+    /**
+     * \brief groups the regions allocated since the last close into a batch
+     * \param batch_id must increase with every call
+     */
+    void close(uint64_t batch_id);
+    /**
+     * \brief recycles the regions of all batches with id <= finished_id
+     */
+    void release(uint64_t finished_id);
+
+    static constexpr VkDeviceSize DEFAULT_CAPACITY = 16ull * 1024 * 1024;
+    static constexpr VkDeviceSize MAX_CAPACITY = 256ull * 1024 * 1024;
+    static constexpr VkDeviceSize DEFAULT_ALIGNMENT = 16;
+
+private:
+    struct Batch {
+        uint64_t id;
+        VkDeviceSize end; /*head of the ring buffer at close*/
+        bool currentBuffer; /*false -> regions live in a retired buffer*/
+    };
+    struct RetiredBuffer {
+        unique_ptr<DefaultBuffer> buffer;
+        optional<uint64_t> lastBatch; /*buffer is released once this batch finished, nullopt -> batch not closed yet*/
+    };
+
+    /**
+     * \return offset of the region, nullopt -> ring full
+     */
+    [[nodiscard]] optional<VkDeviceSize> fit(VkDeviceSize size, VkDeviceSize alignment) const;
+    /**
+     * \param min_capacity in bytes
+     */
+    void grow(VkDeviceSize min_capacity);
+    void createBuffer(VkDeviceSize buffer_capacity);
+
+    Device* device;
+
+    unique_ptr<DefaultBuffer> buffer;
+    span<char> mapped{};
+    VkDeviceSize capacity = 0;
+    VkDeviceSize head = 0;
+    VkDeviceSize tail = 0;
+    bool open = false; /*regions allocated since the last close*/
+
+    deque<Batch> batches{};
+    vector<RetiredBuffer> retiredBuffers{};
+
+public:
+    /**
+     * \param capacity initial size in bytes
+     */
+    explicit StagingRing(Device* device, VkDeviceSize capacity = DEFAULT_CAPACITY);
+    ~StagingRing();
+
+    [[nodiscard]] VkDeviceSize size() const { return capacity; }
+    /**
+     * \return id of the oldest unreleased batch, nullopt -> no closed batches
+     */
+    [[nodiscard]] optional<uint64_t> oldestBatch() const { return batches.empty() ? nullopt : optional{batches.front().id}; }
+
+    StagingRing(const StagingRing& other) = delete;
+    StagingRing(StagingRing&& other) = delete;
+    StagingRing& operator=(const StagingRing& other) = delete;
+    StagingRing& operator=(StagingRing&& other) = delete;
+};
+
+} // namespace cth
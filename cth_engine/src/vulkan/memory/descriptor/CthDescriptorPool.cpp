@@ -1,7 +1,10 @@
 #include "CthDescriptorPool.hpp"
 
 #include "CthDescriptorSet.hpp"
+#include "vulkan/base/CthDeletionQueue.hpp"
 #include "vulkan/base/CthDevice.hpp"
+#include "vulkan/debug/CthResourceTracker.hpp"
+#include "vulkan/memory/allocator/CthHostAllocator.hpp"
 #include "vulkan/utility/CthVkUtils.hpp"
 
 #include "vulkan/pipeline/layout/CthDescriptorSetLayout.hpp"
@@ -102,9 +105,10 @@ void DescriptorPool::create() {
     createInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
     createInfo.maxSets = static_cast<uint32_t>(vkSets.size());
 
-    const VkResult createResult = vkCreateDescriptorPool(device->get(), &createInfo, nullptr, &vkPool);
+    const VkResult createResult = vkCreateDescriptorPool(device->get(), &createInfo, HostAllocator::callbacks(HostAllocator::CATEGORY_DESCRIPTOR), &vkPool);
     CTH_STABLE_ERR(createResult != VK_SUCCESS, "vk: failed to create descriptor pool")
         throw cth::except::vk_result_exception(createResult, details->exception());
+    if constexpr(ResourceTracker::ENABLED) device->resourceTracker()->add(ResourceTracker::TYPE_DESCRIPTOR_POOL, vkPool, 0, "DescriptorPool");
 }
 
 void DescriptorPool::allocSets() {
@@ -146,6 +150,6 @@ DescriptorPool::DescriptorPool(Device* device, const Builder& builder) : device(
 
 DescriptorPool::~DescriptorPool() {
     if(vkPool == VK_NULL_HANDLE) return;
-    vkDestroyDescriptorPool(device->get(), vkPool, nullptr);
+    device->deletionQueue()->enqueue(DeletionQueue::TYPE_DESCRIPTOR_POOL, vkPool);
 }
 } // namespace cth
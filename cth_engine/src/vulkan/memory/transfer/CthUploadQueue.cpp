@@ -0,0 +1,499 @@
+#include "CthUploadQueue.hpp"
+
+#include "vulkan/base/CthDevice.hpp"
+#include "vulkan/debug/CthResourceTracker.hpp"
+#include "vulkan/memory/allocator/CthHostAllocator.hpp"
+#include "vulkan/utility/CthVkUtils.hpp"
+
+#include <cth/cth_log.hpp>
+
+#include <algorithm>
+
+
+
+namespace cth {
+UploadQueue::Ticket UploadQueue::stage(const span<const char> data, VkBuffer dst, const VkDeviceSize dst_offset) {
+    const auto region = stageData(data);
+    return copy(region.buffer, dst, data.size(), region.offset, dst_offset);
+}
+UploadQueue::Ticket UploadQueue::stage(const span<const char> data, VkImage image, const uint32_t width, const uint32_t height,
+    const uint32_t layer_count) {
+    const auto region = stageData(data);
+    return copy(region.buffer, image, width, height, layer_count, region.offset);
+}
+
+UploadQueue::Ticket UploadQueue::copy(VkBuffer src, VkBuffer dst, const VkDeviceSize size, const VkDeviceSize src_offset,
+    const VkDeviceSize dst_offset) {
+    const VkCommandBuffer commandBuffer = beginRecording();
+    orderAfterResident(commandBuffer);
+
+    VkBufferCopy copyRegion{};
+    copyRegion.srcOffset = src_offset;
+    copyRegion.dstOffset = dst_offset;
+    copyRegion.size = size;
+    vkCmdCopyBuffer(commandBuffer, src, dst, 1, &copyRegion);
+
+    release(dst, dst_offset, size);
+
+    return nextTicket;
+}
+UploadQueue::Ticket UploadQueue::copyResident(VkBuffer src, VkBuffer dst, const VkDeviceSize size, const VkDeviceSize src_offset,
+    const VkDeviceSize dst_offset) {
+    VkBufferCopy copyRegion{};
+    copyRegion.srcOffset = src_offset;
+    copyRegion.dstOffset = dst_offset;
+    copyRegion.size = size;
+
+    return copyResident(src, dst, span{&copyRegion, 1});
+}
+UploadQueue::Ticket UploadQueue::copyResident(VkBuffer src, VkBuffer dst, const span<const VkBufferCopy> regions) {
+    if(regions.empty()) return nextTicket;
+
+    //the buffers are owned by the graphics family, the transfer queue must not touch them
+    //the acquire submit runs after the transfer submit of the batch, later copies go into the next batch to keep program order
+    if(device->dedicatedTransfer()) {
+        static_cast<void>(beginRecording());
+        residentCopies.push_back(ResidentCopy{src, dst, vector<VkBufferCopy>{regions.begin(), regions.end()}});
+        return submit();
+    }
+
+    const VkCommandBuffer commandBuffer = beginRecording();
+
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0,
+        nullptr);
+    vkCmdCopyBuffer(commandBuffer, src, dst, static_cast<uint32_t>(regions.size()), regions.data());
+    residentRecorded = true;
+
+    return nextTicket;
+}
+UploadQueue::Ticket UploadQueue::copy(VkBuffer src, VkImage image, const uint32_t width, const uint32_t height, const uint32_t layer_count,
+    const VkDeviceSize src_offset) {
+    VkBufferImageCopy region{};
+    region.bufferOffset = src_offset;
+    region.bufferRowLength = 0;
+    region.bufferImageHeight = 0;
+
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount = layer_count;
+
+    region.imageOffset = {0, 0, 0};
+    region.imageExtent = {width, height, 1};
+
+    const VkCommandBuffer commandBuffer = beginRecording();
+    orderAfterResident(commandBuffer);
+    vkCmdCopyBufferToImage(commandBuffer, src, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+    return nextTicket;
+}
+UploadQueue::Ticket UploadQueue::transition(VkImage image, const VkImageLayout old_layout, const VkImageLayout new_layout,
+    const uint32_t mip_levels, const uint32_t layer_count) {
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.oldLayout = old_layout;
+    barrier.newLayout = new_layout;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = mip_levels;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = layer_count;
+
+    VkPipelineStageFlags srcStage;
+    VkPipelineStageFlags dstStage;
+
+    if(old_layout == VK_IMAGE_LAYOUT_UNDEFINED && new_layout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+        srcStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+        dstStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    } else if(old_layout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && new_layout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+        srcStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        dstStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+
+        if(device->dedicatedTransfer()) {
+            barrier.srcQueueFamilyIndex = device->queueFamilies().transferFamilyIndex;
+            barrier.dstQueueFamilyIndex = device->queueFamilies().graphicsFamilyIndex;
+
+            //the transfer family cannot execute fragment stages, the graphics queue acquires the image
+            VkImageMemoryBarrier acquire = barrier;
+            acquire.srcAccessMask = 0;
+            imageAcquires.push_back(acquire);
+
+            barrier.dstAccessMask = 0;
+            dstStage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+        }
+    } else {
+        CTH_STABLE_ERR(true, "layout transition not supported") {
+            details->add("old layout: {0}, new layout: {1}", static_cast<uint32_t>(old_layout), static_cast<uint32_t>(new_layout));
+            throw details->exception();
+        }
+        return nextTicket;
+    }
+
+    vkCmdPipelineBarrier(beginRecording(), srcStage, dstStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    return nextTicket;
+}
+
+UploadQueue::Ticket UploadQueue::submit() {
+    if(recordBuffer == VK_NULL_HANDLE) return nextTicket - 1;
+
+    Batch batch{nextTicket, 0, recordBuffer, VK_NULL_HANDLE, VK_NULL_HANDLE};
+
+    if(device->dedicatedTransfer()) submitDedicated(batch);
+    else submitShared(batch);
+
+    const Ticket ticket = nextTicket++;
+    inFlight.push_back(batch);
+    stagingRing->close(ticket);
+    recordBuffer = VK_NULL_HANDLE;
+
+    return ticket;
+}
+void UploadQueue::update() {
+    while(!inFlight.empty()) {
+        const Batch& batch = inFlight.front();
+        if(!device->timeline()->reached(batch.value)) break;
+
+        freeCommandBuffers.push_back(batch.commandBuffer);
+        if(batch.acquireBuffer != VK_NULL_HANDLE) freeAcquireBuffers.push_back(batch.acquireBuffer);
+        if(batch.semaphore != VK_NULL_HANDLE) freeSemaphores.push_back(batch.semaphore);
+
+        finishedTicket = batch.ticket;
+        inFlight.pop_front();
+    }
+
+    stagingRing->release(finishedTicket);
+}
+
+bool UploadQueue::finished(const Ticket ticket) {
+    if(ticket <= finishedTicket) return true;
+    update();
+    return ticket <= finishedTicket;
+}
+void UploadQueue::wait(const Ticket ticket) {
+    if(ticket <= finishedTicket) return;
+    if(ticket >= nextTicket) submit();
+
+    const auto it = ranges::find_if(inFlight, [ticket](const Batch& batch) { return batch.ticket >= ticket; });
+    if(it != inFlight.end()) device->timeline()->wait(it->value);
+
+    update();
+}
+void UploadQueue::waitIdle() { wait(submit()); }
+
+void UploadQueue::createCommandPools() {
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.queueFamilyIndex = device->queueFamilies().transferFamilyIndex;
+    //buffers are reset one by one when their batch finished
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+    const VkResult transferResult = vkCreateCommandPool(device->get(), &poolInfo, HostAllocator::callbacks(HostAllocator::CATEGORY_DEVICE), &transferPool);
+    CTH_STABLE_ERR(transferResult != VK_SUCCESS, "failed to create upload transfer command pool")
+        throw cth::except::vk_result_exception{transferResult, details->exception()};
+    if constexpr(ResourceTracker::ENABLED) device->resourceTracker()->add(ResourceTracker::TYPE_COMMAND_POOL, transferPool, 0, "UploadQueue transfer");
+
+    poolInfo.queueFamilyIndex = device->queueFamilies().graphicsFamilyIndex;
+
+    const VkResult graphicsResult = vkCreateCommandPool(device->get(), &poolInfo, HostAllocator::callbacks(HostAllocator::CATEGORY_DEVICE), &graphicsPool);
+    CTH_STABLE_ERR(graphicsResult != VK_SUCCESS, "failed to create upload graphics command pool") {
+        //the destructor doesn't run for a throwing constructor
+        if constexpr(ResourceTracker::ENABLED) device->resourceTracker()->remove(ResourceTracker::TYPE_COMMAND_POOL, transferPool);
+        vkDestroyCommandPool(device->get(), transferPool, HostAllocator::callbacks(HostAllocator::CATEGORY_DEVICE));
+        throw cth::except::vk_result_exception{graphicsResult, details->exception()};
+    }
+    if constexpr(ResourceTracker::ENABLED) device->resourceTracker()->add(ResourceTracker::TYPE_COMMAND_POOL, graphicsPool, 0, "UploadQueue graphics");
+}
+VkCommandBuffer UploadQueue::beginRecording() {
+    if(recordBuffer != VK_NULL_HANDLE) return recordBuffer;
+
+    recordBuffer = beginCommandBuffer(transferPool, freeCommandBuffers);
+
+    //frames still in flight may read the destinations, a shared queue batch waits for them to finish
+    //a dedicated transfer queue waits for the graphics timeline in submitDedicated() instead
+    if(!device->dedicatedTransfer())
+        vkCmdPipelineBarrier(recordBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 0,
+            nullptr);
+
+    return recordBuffer;
+}
+void UploadQueue::orderAfterResident(VkCommandBuffer command_buffer) {
+    if(!residentRecorded) return;
+
+    //dst may be the destination of a resident copy recorded earlier
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0,
+        nullptr);
+    residentRecorded = false;
+}
+VkCommandBuffer UploadQueue::beginCommandBuffer(VkCommandPool pool, vector<VkCommandBuffer>& free_buffers) const {
+    VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+    if(!free_buffers.empty()) {
+        commandBuffer = free_buffers.back();
+        free_buffers.pop_back();
+    } else {
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandPool = pool;
+        allocInfo.commandBufferCount = 1;
+
+        const VkResult allocResult = vkAllocateCommandBuffers(device->get(), &allocInfo, &commandBuffer);
+        CTH_STABLE_ERR(allocResult != VK_SUCCESS, "failed to allocate upload command buffer")
+            throw cth::except::vk_result_exception{allocResult, details->exception()};
+    }
+
+    //begin implicitly resets the command buffer
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    const VkResult beginResult = vkBeginCommandBuffer(commandBuffer, &beginInfo);
+    CTH_STABLE_ERR(beginResult != VK_SUCCESS, "failed to begin upload command buffer") {
+        free_buffers.push_back(commandBuffer);
+        throw cth::except::vk_result_exception{beginResult, details->exception()};
+    }
+
+    return commandBuffer;
+}
+
+void UploadQueue::submitShared(Batch& batch) const {
+    //make the copies visible to everything submitted after this batch
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+
+    vkCmdPipelineBarrier(batch.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &barrier, 0, nullptr,
+        0, nullptr);
+    residentRecorded = false;
+
+    const VkResult endResult = vkEndCommandBuffer(batch.commandBuffer);
+    CTH_STABLE_ERR(endResult != VK_SUCCESS, "failed to record upload commands")
+        throw cth::except::vk_result_exception{endResult, details->exception()};
+
+    Timeline* timeline = device->timeline();
+    batch.value = timeline->reserve();
+    const VkSemaphore timelineSemaphore = timeline->get();
+
+    VkTimelineSemaphoreSubmitInfo timelineInfo{};
+    timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timelineInfo.signalSemaphoreValueCount = 1;
+    timelineInfo.pSignalSemaphoreValues = &batch.value;
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.pNext = &timelineInfo;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &batch.commandBuffer;
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores = &timelineSemaphore;
+
+    const VkResult submitResult = vkQueueSubmit(device->graphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE);
+    CTH_STABLE_ERR(submitResult != VK_SUCCESS, "failed to submit upload batch")
+        throw cth::except::vk_result_exception{submitResult, details->exception()};
+}
+void UploadQueue::submitDedicated(Batch& batch) {
+    if(!bufferReleases.empty())
+        vkCmdPipelineBarrier(batch.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr,
+            static_cast<uint32_t>(bufferReleases.size()), bufferReleases.data(), 0, nullptr);
+
+    const VkResult endResult = vkEndCommandBuffer(batch.commandBuffer);
+    CTH_STABLE_ERR(endResult != VK_SUCCESS, "failed to record upload commands")
+        throw cth::except::vk_result_exception{endResult, details->exception()};
+
+
+    //acquire the released resources on the graphics queue
+    batch.acquireBuffer = beginCommandBuffer(graphicsPool, freeAcquireBuffers);
+
+    vector<VkBufferMemoryBarrier> bufferAcquires = bufferReleases;
+    ranges::for_each(bufferAcquires, [](VkBufferMemoryBarrier& acquire) {
+        acquire.srcAccessMask = 0;
+        acquire.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+    });
+
+    if(!bufferAcquires.empty() || !imageAcquires.empty())
+        vkCmdPipelineBarrier(batch.acquireBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr,
+            static_cast<uint32_t>(bufferAcquires.size()), bufferAcquires.data(), static_cast<uint32_t>(imageAcquires.size()),
+            imageAcquires.data());
+
+    if(!residentCopies.empty()) {
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+
+        vkCmdPipelineBarrier(batch.acquireBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0,
+            nullptr, 0, nullptr);
+
+        ranges::for_each(residentCopies, [&batch](const ResidentCopy& resident_copy) {
+            vkCmdCopyBuffer(batch.acquireBuffer, resident_copy.src, resident_copy.dst, static_cast<uint32_t>(resident_copy.regions.size()),
+                resident_copy.regions.data());
+        });
+
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+
+        vkCmdPipelineBarrier(batch.acquireBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &barrier, 0,
+            nullptr, 0, nullptr);
+    }
+
+    const VkResult acquireResult = vkEndCommandBuffer(batch.acquireBuffer);
+    CTH_STABLE_ERR(acquireResult != VK_SUCCESS, "failed to record upload acquire commands") {
+        freeAcquireBuffers.push_back(batch.acquireBuffer);
+        throw cth::except::vk_result_exception{acquireResult, details->exception()};
+    }
+
+    batch.semaphore = acquireSemaphore();
+
+
+    //the copies may overwrite what earlier graphics submits still read, or the destinations of their resident copies
+    constexpr uint64_t binaryValue = 0; /*ignored for binary semaphores*/
+    constexpr VkPipelineStageFlags transferWaitStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    const VkSemaphore timelineSemaphore = device->timeline()->get();
+    const Timeline::Value graphicsValue = device->timeline()->submitted();
+
+    VkTimelineSemaphoreSubmitInfo transferTimelineInfo{};
+    transferTimelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    transferTimelineInfo.waitSemaphoreValueCount = 1;
+    transferTimelineInfo.pWaitSemaphoreValues = &graphicsValue;
+    transferTimelineInfo.signalSemaphoreValueCount = 1;
+    transferTimelineInfo.pSignalSemaphoreValues = &binaryValue;
+
+    VkSubmitInfo transferSubmit{};
+    transferSubmit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    if(graphicsValue != 0) {
+        transferSubmit.pNext = &transferTimelineInfo;
+        transferSubmit.waitSemaphoreCount = 1;
+        transferSubmit.pWaitSemaphores = &timelineSemaphore;
+        transferSubmit.pWaitDstStageMask = &transferWaitStage;
+    }
+    transferSubmit.commandBufferCount = 1;
+    transferSubmit.pCommandBuffers = &batch.commandBuffer;
+    transferSubmit.signalSemaphoreCount = 1;
+    transferSubmit.pSignalSemaphores = &batch.semaphore;
+
+    const VkResult transferResult = vkQueueSubmit(device->transferQueue(), 1, &transferSubmit, VK_NULL_HANDLE);
+    CTH_STABLE_ERR(transferResult != VK_SUCCESS, "failed to submit upload batch") {
+        freeAcquireBuffers.push_back(batch.acquireBuffer);
+        freeSemaphores.push_back(batch.semaphore);
+        throw cth::except::vk_result_exception{transferResult, details->exception()};
+    }
+
+    constexpr VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+    //the acquire submit waits for the transfer submit, its timeline value covers the whole batch
+    batch.value = device->timeline()->reserve();
+
+    VkTimelineSemaphoreSubmitInfo timelineInfo{};
+    timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timelineInfo.waitSemaphoreValueCount = 1;
+    timelineInfo.pWaitSemaphoreValues = &binaryValue;
+    timelineInfo.signalSemaphoreValueCount = 1;
+    timelineInfo.pSignalSemaphoreValues = &batch.value;
+
+    VkSubmitInfo acquireSubmit{};
+    acquireSubmit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    acquireSubmit.pNext = &timelineInfo;
+    acquireSubmit.waitSemaphoreCount = 1;
+    acquireSubmit.pWaitSemaphores = &batch.semaphore;
+    acquireSubmit.pWaitDstStageMask = &waitStage;
+    acquireSubmit.commandBufferCount = 1;
+    acquireSubmit.pCommandBuffers = &batch.acquireBuffer;
+    acquireSubmit.signalSemaphoreCount = 1;
+    acquireSubmit.pSignalSemaphores = &timelineSemaphore;
+
+    //the batch is in flight at this point, a failure leaves the device lost anyways
+    const VkResult acquireSubmitResult = vkQueueSubmit(device->graphicsQueue(), 1, &acquireSubmit, VK_NULL_HANDLE);
+    CTH_STABLE_ERR(acquireSubmitResult != VK_SUCCESS, "failed to submit upload acquire batch")
+        throw cth::except::vk_result_exception{acquireSubmitResult, details->exception()};
+
+    bufferReleases.clear();
+    imageAcquires.clear();
+    residentCopies.clear();
+}
+void UploadQueue::release(VkBuffer dst, const VkDeviceSize offset, const VkDeviceSize size) {
+    if(!device->dedicatedTransfer()) return;
+
+    VkBufferMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = 0;
+    barrier.srcQueueFamilyIndex = device->queueFamilies().transferFamilyIndex;
+    barrier.dstQueueFamilyIndex = device->queueFamilies().graphicsFamilyIndex;
+    barrier.buffer = dst;
+    barrier.offset = offset;
+    barrier.size = size;
+
+    bufferReleases.push_back(barrier);
+}
+
+StagingRing::Region UploadQueue::stageData(const span<const char> data) {
+    update();
+
+    optional<StagingRing::Region> region = stagingRing->allocate(data.size());
+    while(region == nullopt) {
+        //allocate only fails if closed batches occupy the ring
+        wait(*stagingRing->oldestBatch());
+        region = stagingRing->allocate(data.size());
+    }
+
+    ranges::copy(data, region->memory.begin());
+    return *region;
+}
+VkSemaphore UploadQueue::acquireSemaphore() {
+    if(!freeSemaphores.empty()) {
+        const VkSemaphore semaphore = freeSemaphores.back();
+        freeSemaphores.pop_back();
+        return semaphore;
+    }
+
+    VkSemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+    VkSemaphore semaphore = VK_NULL_HANDLE;
+    const VkResult createResult = vkCreateSemaphore(device->get(), &semaphoreInfo, HostAllocator::callbacks(HostAllocator::CATEGORY_DEVICE), &semaphore);
+    CTH_STABLE_ERR(createResult != VK_SUCCESS, "failed to create upload semaphore")
+        throw cth::except::vk_result_exception{createResult, details->exception()};
+    if constexpr(ResourceTracker::ENABLED) device->resourceTracker()->add(ResourceTracker::TYPE_SEMAPHORE, semaphore, 0, "UploadQueue");
+
+    return semaphore;
+}
+
+UploadQueue::UploadQueue(Device* device) : device(device), stagingRing(make_unique<StagingRing>(device)) { createCommandPools(); }
+UploadQueue::~UploadQueue() {
+    waitIdle();
+
+    ranges::for_each(freeSemaphores, [this](VkSemaphore semaphore) {
+        if constexpr(ResourceTracker::ENABLED) device->resourceTracker()->remove(ResourceTracker::TYPE_SEMAPHORE, semaphore);
+        vkDestroySemaphore(device->get(), semaphore, HostAllocator::callbacks(HostAllocator::CATEGORY_DEVICE));
+    });
+
+    //destroying the pools frees their command buffers
+    if constexpr(ResourceTracker::ENABLED) {
+        device->resourceTracker()->remove(ResourceTracker::TYPE_COMMAND_POOL, transferPool);
+        device->resourceTracker()->remove(ResourceTracker::TYPE_COMMAND_POOL, graphicsPool);
+    }
+    vkDestroyCommandPool(device->get(), transferPool, HostAllocator::callbacks(HostAllocator::CATEGORY_DEVICE));
+    vkDestroyCommandPool(device->get(), graphicsPool, HostAllocator::callbacks(HostAllocator::CATEGORY_DEVICE));
+}
+
+} // namespace cth
@@ -0,0 +1,211 @@
+#pragma once
+#include "vulkan/base/CthTimeline.hpp"
+#include "vulkan/memory/buffer/CthStagingRing.hpp"
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <span>
+#include <vector>
+
+
+namespace cth {
+using namespace std;
+class Device;
+
+/**
+ * \brief records buffer copies, image copies and layout transitions into one command buffer and submits them as a batch
+ * \note every batch is tracked by a ticket, tickets increase with every submit
+ * \note batches complete by signaling the devices timeline on the graphics queue
+ * \note records on the devices transfer queue, later submits on the graphics queue see the uploaded data
+ * \note on a dedicated transfer queue written buffer ranges are released to the graphics family,
+ * images are released by the transfer dst -> shader read only transition
+ * \note batches wait for the graphics work submitted before them, destinations may still be read by frames in flight
+ * \note owns its command pools, the buffers are recycled per batch instead of per frame slot like the CommandAllocator
+ * \note not thread safe
+ */
+class UploadQueue {
+public:
+    using Ticket = uint64_t;
+
+    /**
+     * \brief copies data into the staging ring and records a copy to dst
+     * \param dst_offset in bytes
+     * \return ticket of the batch the copy is part of
+     */
+    Ticket stage(span<const char> data, VkBuffer dst, VkDeviceSize dst_offset = 0);
+    /**
+     * \brief copies data into the staging ring and records a copy to the first mip level of image
+     * \note image must be in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL when the copy executes
+     * \return ticket of the batch the copy is part of
+     */
+    Ticket stage(span<const char> data, VkImage image, uint32_t width, uint32_t height, uint32_t layer_count = 1);
+    /**
+     * \param size in bytes
+     * \param src_offset in bytes
+     * \param dst_offset in bytes
+     * \note src must not be owned by another queue family than the transfer family, e.g. host written buffers
+     * \return ticket of the batch the copy is part of
+     */
+    Ticket copy(VkBuffer src, VkBuffer dst, VkDeviceSize size, VkDeviceSize src_offset = 0, VkDeviceSize dst_offset = 0);
+    /**
+     * \brief records a copy between buffers that are already in use by the graphics queue
+     * \param size in bytes
+     * \param src_offset in bytes
+     * \param dst_offset in bytes
+     * \note waits for earlier graphics submits to finish writing the buffers
+     * \note executes in program order, after the commands recorded before and before the commands recorded after it
+     * \note on a dedicated transfer queue the copy is recorded into the graphics queue acquire submit of the batch,
+     * the batch is submitted immediately and the next transfer submit waits for it on the timeline
+     * \return ticket of the batch the copy is part of
+     */
+    Ticket copyResident(VkBuffer src, VkBuffer dst, VkDeviceSize size, VkDeviceSize src_offset = 0, VkDeviceSize dst_offset = 0);
+    /**
+     * \brief records one copy with all regions between buffers that are already in use by the graphics queue
+     * \param regions offsets and sizes in bytes
+     * \note see copyResident() above
+     * \return ticket of the batch the copy is part of
+     */
+    Ticket copyResident(VkBuffer src, VkBuffer dst, span<const VkBufferCopy> regions);
+    /**
+     * \param src_offset in bytes
+     * \note image must be in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL when the copy executes
+     * \note src must not be owned by another queue family than the transfer family, e.g. host written buffers
+     * \return ticket of the batch the copy is part of
+     */
+    Ticket copy(VkBuffer src, VkImage image, uint32_t width, uint32_t height, uint32_t layer_count = 1, VkDeviceSize src_offset = 0);
+    /**
+     * \brief records a layout transition of all mip levels and layers
+     * \note supported: undefined -> transfer dst, transfer dst -> shader read only
+     * \return ticket of the batch the transition is part of
+     * \throws cth::except::default_exception reason: layout transition not supported
+     */
+    Ticket transition(VkImage image, VkImageLayout old_layout, VkImageLayout new_layout, uint32_t mip_levels = 1, uint32_t layer_count = 1);
+
+    /**
+     * \brief submits the recorded commands, does nothing if nothing was recorded
+     * \note on a dedicated transfer queue the batch is acquired by a second submit on the graphics queue
+     * \return ticket of the submitted batch, last submitted ticket if nothing was recorded
+     * \throws cth::except::vk_result_exception result of vkEndCommandBuffer()
+     * \throws cth::except::vk_result_exception result of vkQueueSubmit()
+     */
+    Ticket submit();
+    /**
+     * \brief recycles the command buffers and staging memory of all finished batches
+     */
+    void update();
+
+    /**
+     * \return true if the batch finished on the gpu
+     */
+    [[nodiscard]] bool finished(Ticket ticket);
+    /**
+     * \brief blocks until the batch finished, submits the batch if it is still recording
+     */
+    void wait(Ticket ticket);
+    /**
+     * \brief submits and blocks until all batches finished
+     */
+    void waitIdle();
+
+private:
+    struct Batch {
+        Ticket ticket;
+        Timeline::Value value; /*signaled by the graphics queue submit of the batch*/
+        VkCommandBuffer commandBuffer;
+        VkCommandBuffer acquireBuffer; /*graphics queue ownership acquire, VK_NULL_HANDLE -> no dedicated transfer queue*/
+        VkSemaphore semaphore; /*signaled by the transfer submit, VK_NULL_HANDLE -> no dedicated transfer queue*/
+    };
+    struct ResidentCopy {
+        VkBuffer src;
+        VkBuffer dst;
+        vector<VkBufferCopy> regions;
+    };
+
+    /**
+     * \brief creates the transfer pool and the graphics pool for the acquire submits
+     * \throws cth::except::vk_result_exception result of vkCreateCommandPool()
+     */
+    void createCommandPools();
+    /**
+     * \return recording command buffer, begins one if necessary
+     * \throws cth::except::vk_result_exception result of vkAllocateCommandBuffers()
+     * \throws cth::except::vk_result_exception result of vkBeginCommandBuffer()
+     */
+    [[nodiscard]] VkCommandBuffer beginRecording();
+    /**
+     * \brief orders transfer writes after the resident copies recorded before, shared queue only
+     */
+    void orderAfterResident(VkCommandBuffer command_buffer);
+    /**
+     * \brief begins a command buffer from pool, reuses one of free_buffers if possible
+     * \throws cth::except::vk_result_exception result of vkAllocateCommandBuffers()
+     * \throws cth::except::vk_result_exception result of vkBeginCommandBuffer()
+     */
+    [[nodiscard]] VkCommandBuffer beginCommandBuffer(VkCommandPool pool, vector<VkCommandBuffer>& free_buffers) const;
+    /**
+     * \brief submits the batch on the graphics queue
+     * \throws cth::except::vk_result_exception result of vkQueueSubmit()
+     */
+    void submitShared(Batch& batch) const;
+    /**
+     * \brief submits the batch on the transfer queue and acquires its resources on the graphics queue
+     * \throws cth::except::vk_result_exception result of vkQueueSubmit()
+     */
+    void submitDedicated(Batch& batch);
+    /**
+     * \brief releases dst range to the graphics family, does nothing without a dedicated transfer queue
+     */
+    void release(VkBuffer dst, VkDeviceSize offset, VkDeviceSize size);
+    /**
+     * \brief copies data into a staging region, waits for the oldest batch if the staging ring is full
+     */
+    [[nodiscard]] StagingRing::Region stageData(span<const char> data);
+    /**
+     * \throws cth::except::vk_result_exception result of vkCreateSemaphore()
+     */
+    [[nodiscard]] VkSemaphore acquireSemaphore();
+
+    Device* device;
+    unique_ptr<StagingRing> stagingRing;
+    VkCommandPool transferPool = VK_NULL_HANDLE;
+    VkCommandPool graphicsPool = VK_NULL_HANDLE; /*graphics queue acquires and resident copies*/
+
+    VkCommandBuffer recordBuffer = VK_NULL_HANDLE;
+    Ticket nextTicket = 1;
+    Ticket finishedTicket = 0;
+
+    vector<VkBufferMemoryBarrier> bufferReleases{};
+    vector<VkImageMemoryBarrier> imageAcquires{};
+    vector<ResidentCopy> residentCopies{}; /*recorded on the graphics queue, only used with a dedicated transfer queue*/
+    bool residentRecorded = false; /*shared queue: a resident copy was recorded since the last transfer barrier*/
+
+    deque<Batch> inFlight{};
+    vector<VkSemaphore> freeSemaphores{};
+    vector<VkCommandBuffer> freeCommandBuffers{};
+    vector<VkCommandBuffer> freeAcquireBuffers{};
+
+public:
+    /**
+     * \throws cth::except::vk_result_exception result of vkCreateCommandPool()
+     */
+    explicit UploadQueue(Device* device);
+    ~UploadQueue();
+
+    /**
+     * \return ticket the recorded commands will be submitted with
+     */
+    [[nodiscard]] Ticket pendingTicket() const { return nextTicket; }
+    [[nodiscard]] Ticket lastFinished() const { return finishedTicket; }
+    [[nodiscard]] bool recording() const { return recordBuffer != VK_NULL_HANDLE; }
+    [[nodiscard]] StagingRing* staging() const { return stagingRing.get(); }
+
+    UploadQueue(const UploadQueue& other) = delete;
+    UploadQueue(UploadQueue&& other) = delete;
+    UploadQueue& operator=(const UploadQueue& other) = delete;
+    UploadQueue& operator=(UploadQueue&& other) = delete;
+};
+
+} // namespace cth
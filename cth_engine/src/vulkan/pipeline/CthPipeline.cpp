@@ -1,6 +1,9 @@
 #include "CthPipeline.hpp"
 
+#include "vulkan/base/CthDeletionQueue.hpp"
 #include "vulkan/base/CthDevice.hpp"
+#include "vulkan/debug/CthResourceTracker.hpp"
+#include "vulkan/memory/allocator/CthHostAllocator.hpp"
 #include "vulkan/pipeline/shader/CthShader.hpp"
 #include "vulkan/render/model/HlcVertex.hpp"
 #include "vulkan//utility/CthVkUtils.hpp"
@@ -13,9 +16,7 @@ namespace cth {
 using namespace std;
 
 Pipeline::Pipeline(Device* device, const PipelineConfigInfo& config_info) : device{device} { createGraphicsPipeline(config_info); }
-Pipeline::~Pipeline() {
-    vkDestroyPipeline(device->get(), vkGraphicsPipeline, nullptr);
-}
+Pipeline::~Pipeline() { device->deletionQueue()->enqueue(DeletionQueue::TYPE_PIPELINE, vkGraphicsPipeline); }
 
 void Pipeline::createGraphicsPipeline(const PipelineConfigInfo& config_info) {
     CTH_STABLE_ERR(config_info.pipelineLayout == VK_NULL_HANDLE, "pipelineLayout missing in config_info")
@@ -67,12 +68,13 @@ void Pipeline::createGraphicsPipeline(const PipelineConfigInfo& config_info) {
     pipelineInfo.basePipelineIndex = -1;
     pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
-    const VkResult createResult = vkCreateGraphicsPipelines(device->get(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr,
+    const VkResult createResult = vkCreateGraphicsPipelines(device->get(), VK_NULL_HANDLE, 1, &pipelineInfo, HostAllocator::callbacks(HostAllocator::CATEGORY_PIPELINE),
         &vkGraphicsPipeline);
 
 
     CTH_STABLE_ERR(createResult != VK_SUCCESS, "failed to create graphics pipeline")
         throw cth::except::vk_result_exception{createResult, details->exception()};
+    if constexpr(ResourceTracker::ENABLED) device->resourceTracker()->add(ResourceTracker::TYPE_PIPELINE, vkGraphicsPipeline, 0, "Pipeline");
 
 
 }
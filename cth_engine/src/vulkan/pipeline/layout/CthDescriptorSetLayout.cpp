@@ -3,6 +3,7 @@
 
 
 #include "vulkan/base/CthDevice.hpp"
+#include "vulkan/memory/allocator/CthHostAllocator.hpp"
 #include "vulkan/memory/descriptor/CthDescriptor.hpp"
 #include "vulkan/utility/CthVkUtils.hpp"
 
@@ -36,11 +37,11 @@ DescriptorSetLayout::DescriptorSetLayout(Device* device, const Builder& builder)
     descriptorSetLayoutInfo.bindingCount = static_cast<uint32_t>(vkBindings.size());
     descriptorSetLayoutInfo.pBindings = vkBindings.data();
 
-    const VkResult result = vkCreateDescriptorSetLayout(device->get(), &descriptorSetLayoutInfo, nullptr, &vkLayout);
+    const VkResult result = vkCreateDescriptorSetLayout(device->get(), &descriptorSetLayoutInfo, HostAllocator::callbacks(HostAllocator::CATEGORY_DESCRIPTOR), &vkLayout);
     CTH_STABLE_ERR(result != VK_SUCCESS, "Vk: failed to create descriptor set layout")
         throw cth::except::vk_result_exception(result, details->exception());
 }
 DescriptorSetLayout::~DescriptorSetLayout() {
-    vkDestroyDescriptorSetLayout(device->get(), vkLayout, nullptr);
+    vkDestroyDescriptorSetLayout(device->get(), vkLayout, HostAllocator::callbacks(HostAllocator::CATEGORY_DESCRIPTOR));
 }
 } // namespace cth
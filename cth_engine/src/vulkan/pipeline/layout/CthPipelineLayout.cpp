@@ -2,6 +2,7 @@
 
 #include "CthDescriptorSetLayout.hpp"
 #include "vulkan/base/CthDevice.hpp"
+#include "vulkan/memory/allocator/CthHostAllocator.hpp"
 #include "vulkan/utility/CthVkUtils.hpp"
 
 
@@ -21,7 +22,7 @@ namespace cth {
         pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(vkLayouts.size());
         pipelineLayoutInfo.pSetLayouts = vkLayouts.data();
 
-        const VkResult result = vkCreatePipelineLayout(device->get(), &pipelineLayoutInfo, nullptr, &vkLayout);
+        const VkResult result = vkCreatePipelineLayout(device->get(), &pipelineLayoutInfo, HostAllocator::callbacks(HostAllocator::CATEGORY_PIPELINE), &vkLayout);
 
         CTH_STABLE_ERR(result != VK_SUCCESS, "failed to create pipeline layout")
             throw except::vk_result_exception(result, details->exception());
@@ -34,7 +35,7 @@ namespace cth {
         create();
     }
     PipelineLayout::~PipelineLayout() {
-        vkDestroyPipelineLayout(device->get(), vkLayout, nullptr);
+        vkDestroyPipelineLayout(device->get(), vkLayout, HostAllocator::callbacks(HostAllocator::CATEGORY_PIPELINE));
         log::msg("destroyed pipeline layout");
     }
 }
@@ -1,6 +1,8 @@
 #include "CthShader.hpp"
 
 #include "vulkan/base/CthDevice.hpp"
+#include "vulkan/debug/CthResourceTracker.hpp"
+#include "vulkan/memory/allocator/CthHostAllocator.hpp"
 #include "vulkan/utility/CthVkUtils.hpp"
 
 
@@ -46,13 +48,16 @@ void Shader::create() {
     createInfo.codeSize = bytecode.size();
     createInfo.pCode = reinterpret_cast<uint32_t*>(bytecode.data());
 
-    const VkResult createResult = vkCreateShaderModule(device->get(), &createInfo, nullptr, &vkModule);
+    const VkResult createResult = vkCreateShaderModule(device->get(), &createInfo, HostAllocator::callbacks(HostAllocator::CATEGORY_PIPELINE), &vkModule);
 
     CTH_STABLE_ERR(createResult != VK_SUCCESS, "failed to create shader module")
         throw cth::except::vk_result_exception{createResult, details->exception()};
 
     CTH_LOG(true, "created shader module: ")
         details->add("file: {0}", filesystem::path(spvPath).filename().string());
+
+    if constexpr(ResourceTracker::ENABLED)
+        device->resourceTracker()->add(ResourceTracker::TYPE_SHADER, vkModule, bytecode.size(), filesystem::path(spvPath).filename().string());
 }
 void Shader::init() {
     loadSpv();
@@ -134,6 +139,9 @@ Shader::Shader(Device* device, const Shader_Type type, const string_view spv_pat
 #endif //_FINAL
 
 Shader::Shader(Device* device, const Shader_Type type, const string_view spv_path) : device(device), type(type), spvPath(spv_path) { init(); }
-Shader::~Shader() { vkDestroyShaderModule(device->get(), vkModule, nullptr); }
+Shader::~Shader() {
+    if constexpr(ResourceTracker::ENABLED) device->resourceTracker()->remove(ResourceTracker::TYPE_SHADER, vkModule);
+    vkDestroyShaderModule(device->get(), vkModule, HostAllocator::callbacks(HostAllocator::CATEGORY_PIPELINE));
+}
 
 }
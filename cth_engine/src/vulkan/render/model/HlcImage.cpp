@@ -8,7 +8,11 @@
 
 #include <stb_image.h>
 
+#include "vulkan/base/CthDeletionQueue.hpp"
 #include "vulkan/base/CthDevice.hpp"
+#include "vulkan/debug/CthResourceTracker.hpp"
+#include "vulkan/memory/allocator/CthHostAllocator.hpp"
+#include "vulkan/memory/transfer/CthUploadQueue.hpp"
 #include "vulkan/surface/CthSwapchain.hpp"
 
 
@@ -32,6 +36,7 @@ void Image::loadImage(const string& path) {
     //stage(buffer->getBuffer());
 
     imageView = Swapchain::createImageView(device.get(), image, imageInfo.format);
+    if constexpr(ResourceTracker::ENABLED) device.resourceTracker()->add(ResourceTracker::TYPE_IMAGE_VIEW, imageView, 0, "Image");
 
     createDescriptorInfo();
 }
@@ -67,88 +72,39 @@ void Image::createThisImage(const VkImageTiling tiling, const VkImageUsageFlags
     imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
     imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
     imageInfo.flags = 0; //
-    if(vkCreateImage(device.get(), &imageInfo, nullptr, &image) != VK_SUCCESS) throw runtime_error("createImage: failed to create image");
+    if(vkCreateImage(device.get(), &imageInfo, HostAllocator::callbacks(HostAllocator::CATEGORY_RESOURCE), &image) != VK_SUCCESS) throw runtime_error("createImage: failed to create image");
 }
 void Image::allocateThisImage() {
     vkGetImageMemoryRequirements(device.get(), image, &memoryRequirements);
 
-    allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocateInfo.allocationSize = memoryRequirements.size;
-    allocateInfo.memoryTypeIndex = device.findMemoryType(memoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-    if(vkAllocateMemory(device.get(), &allocateInfo, nullptr, &imageMemory) != VK_SUCCESS)
-        throw runtime_error(
-            "allocateImage: failed to allocate memory");
+    imageMemory = device.allocator()->allocate(memoryRequirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, imageInfo.tiling == VK_IMAGE_TILING_LINEAR, 0,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
 
-    vkBindImageMemory(device.get(), image, imageMemory, 0);
+    if(vkBindImageMemory(device.get(), image, imageMemory.memory, imageMemory.offset) != VK_SUCCESS)
+        throw runtime_error("allocateImage: failed to bind memory");
+
+    if constexpr(ResourceTracker::ENABLED) device.resourceTracker()->add(ResourceTracker::TYPE_IMAGE, image, imageMemory.size, "Image");
 }
 
 void Image::transitionImageLayout(const VkImageLayout new_layout) {
-    const auto commandBuffer = device.beginSingleTimeCommands();
-
-    VkImageMemoryBarrier barrier{};
-    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-    barrier.oldLayout = imageLayout;
-    barrier.newLayout = new_layout;
-    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.image = image;
-    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    barrier.subresourceRange.baseMipLevel = 0;
-    barrier.subresourceRange.levelCount = 1;
-    barrier.subresourceRange.baseArrayLayer = 0;
-    barrier.subresourceRange.layerCount = 1;
-
-    VkPipelineStageFlags sourceFlags;
-    VkPipelineStageFlags destinationFlags;
-
-    if(imageLayout == VK_IMAGE_LAYOUT_UNDEFINED && new_layout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
-        barrier.srcAccessMask = 0;
-        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-
-        sourceFlags = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-        destinationFlags = VK_PIPELINE_STAGE_TRANSFER_BIT;
-    } else if(imageLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && new_layout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
-        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-        sourceFlags = VK_PIPELINE_STAGE_TRANSFER_BIT;
-        destinationFlags = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-    } else throw invalid_argument("transitionImageLayout: layout transition undefined");
-
-    vkCmdPipelineBarrier(commandBuffer, sourceFlags, destinationFlags, 0, 0, nullptr, 0, nullptr, 1, &barrier);
-
-    device.endSingleTimeCommands(commandBuffer);
-
+    device.uploadQueue()->transition(image, imageLayout, new_layout);
     imageLayout = new_layout;
 }
 void Image::copyBufferToImage(const VkBuffer buffer) const {
-    const auto commandBuffer = device.beginSingleTimeCommands();
-
-    VkBufferImageCopy region{};
-    region.bufferOffset = 0;
-    region.bufferRowLength = 0;
-    region.bufferImageHeight = 0;
-    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    region.imageSubresource.mipLevel = 0;
-    region.imageSubresource.baseArrayLayer = 0;
-    region.imageSubresource.layerCount = 1;
-    region.imageOffset = {0, 0, 0};
-    region.imageExtent = {static_cast<uint32_t>(width), static_cast<uint32_t>(height), 1};
-    vkCmdCopyBufferToImage(commandBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-
-    device.endSingleTimeCommands(commandBuffer);
+    device.uploadQueue()->copy(buffer, image, static_cast<uint32_t>(width), static_cast<uint32_t>(height));
 }
 
 Image::~Image() {
-    vkDestroyImageView(device.get(), imageView, nullptr);
+    if constexpr(ResourceTracker::ENABLED) device.resourceTracker()->remove(ResourceTracker::TYPE_IMAGE, image);
 
-    vkDestroyImage(device.get(), image, nullptr);
-    vkFreeMemory(device.get(), imageMemory, nullptr);
+    device.deletionQueue()->enqueue(DeletionQueue::TYPE_IMAGE_VIEW, imageView);
+    device.deletionQueue()->enqueue(DeletionQueue::TYPE_IMAGE, image);
+    device.deletionQueue()->enqueue(imageMemory);
 }
 
 void Image::createImage(const uint32_t width, const uint32_t height, const uint32_t mip_levels, const VkSampleCountFlagBits num_samples,
     const VkFormat format, const VkImageTiling tiling,
-    const VkImageUsageFlags usage, const VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& image_memory, const Device& device) {
+    const VkImageUsageFlags usage, const VkMemoryPropertyFlags properties, VkImage& image, MemoryAllocation& image_memory, const Device& device) {
     VkImageCreateInfo imageInfo{};
     imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
     imageInfo.imageType = VK_IMAGE_TYPE_2D;
@@ -164,19 +120,15 @@ void Image::createImage(const uint32_t width, const uint32_t height, const uint3
     imageInfo.samples = num_samples;
     imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
-    if(vkCreateImage(device.get(), &imageInfo, nullptr, &image) != VK_SUCCESS) throw std::runtime_error("failed to create image!");
+    if(vkCreateImage(device.get(), &imageInfo, HostAllocator::callbacks(HostAllocator::CATEGORY_RESOURCE), &image) != VK_SUCCESS) throw std::runtime_error("failed to create image!");
 
     VkMemoryRequirements memRequirements;
     vkGetImageMemoryRequirements(device.get(), image, &memRequirements);
 
-    VkMemoryAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memRequirements.size;
-    allocInfo.memoryTypeIndex = device.findMemoryType(memRequirements.memoryTypeBits, properties);
-
-    if(vkAllocateMemory(device.get(), &allocInfo, nullptr, &image_memory) != VK_SUCCESS) throw std::runtime_error(
-        "failed to allocate image memory!");
+    const VkMemoryPropertyFlags notPreferred = properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT ? 0 : VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+    image_memory = device.allocator()->allocate(memRequirements, properties, tiling == VK_IMAGE_TILING_LINEAR, 0, notPreferred);
 
-    vkBindImageMemory(device.get(), image, image_memory, 0);
+    if(vkBindImageMemory(device.get(), image, image_memory.memory, image_memory.offset) != VK_SUCCESS)
+        throw std::runtime_error("failed to bind image memory!");
 }
 }
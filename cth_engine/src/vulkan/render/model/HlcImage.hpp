@@ -1,4 +1,6 @@
 #pragma once
+#include "vulkan/memory/allocator/CthMemoryAllocator.hpp"
+
 #include <string>
 #include <vulkan/vulkan.h>
 
@@ -27,7 +29,7 @@ public:
 
 
     static void createImage(uint32_t width, uint32_t height, uint32_t mip_levels, VkSampleCountFlagBits num_samples, VkFormat format,
-        VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& image_memory,
+        VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, MemoryAllocation& image_memory,
         const Device& device);
 
 private:
@@ -35,11 +37,10 @@ private:
     VkImage image;
     VkImageLayout imageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
     VkImageView imageView;
-    VkDeviceMemory imageMemory;
+    MemoryAllocation imageMemory{};
     VkImageCreateInfo imageInfo{};
     VkDescriptorImageInfo descriptorInfo{};
     VkMemoryRequirements memoryRequirements;
-    VkMemoryAllocateInfo allocateInfo{};
     void createThisImage(VkImageTiling tiling, VkImageUsageFlags usages);
     void allocateThisImage();
     void transitionImageLayout(VkImageLayout new_layout);
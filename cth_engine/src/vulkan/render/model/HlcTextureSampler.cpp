@@ -1,6 +1,9 @@
 #include "HlcTextureSampler.hpp"
 
+#include "vulkan/base/CthDeletionQueue.hpp"
 #include "vulkan/base/CthDevice.hpp"
+#include "vulkan/debug/CthResourceTracker.hpp"
+#include "vulkan/memory/allocator/CthHostAllocator.hpp"
 
 #include <stdexcept>
 
@@ -35,10 +38,11 @@ namespace cth {
 		samplerInfo.minLod = 0.f;
 		samplerInfo.maxLod = 0.f;
 
-		if(vkCreateSampler(device.get(), &samplerInfo, nullptr, &textureSampler) != VK_SUCCESS) throw runtime_error("HlcTextureSampler: failed to create texture sampler");
+		if(vkCreateSampler(device.get(), &samplerInfo, HostAllocator::callbacks(HostAllocator::CATEGORY_RESOURCE), &textureSampler) != VK_SUCCESS) throw runtime_error("HlcTextureSampler: failed to create texture sampler");
+		if constexpr(ResourceTracker::ENABLED) device.resourceTracker()->add(ResourceTracker::TYPE_SAMPLER, textureSampler, 0, "TextureSampler");
 }
 	HlcTextureSampler::~HlcTextureSampler() {
-		vkDestroySampler(device.get(), textureSampler, nullptr);	
+		device.deletionQueue()->enqueue(DeletionQueue::TYPE_SAMPLER, textureSampler);
 	}
 
 }
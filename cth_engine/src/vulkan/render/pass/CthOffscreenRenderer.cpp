@@ -0,0 +1,445 @@
+#include "CthOffscreenRenderer.hpp"
+
+#include "vulkan/base/CthCommandAllocator.hpp"
+#include "vulkan/base/CthDeletionQueue.hpp"
+#include "vulkan/base/CthDevice.hpp"
+#include "vulkan/debug/CthGpuProfiler.hpp"
+#include "vulkan/debug/CthResourceTracker.hpp"
+#include "vulkan/memory/allocator/CthHostAllocator.hpp"
+#include "vulkan/memory/buffer/CthDefaultBuffer.hpp"
+#include "vulkan/memory/buffer/CthFrameAllocator.hpp"
+#include "vulkan/memory/transfer/CthUploadQueue.hpp"
+#include "vulkan/render/pass/cth_render_pass_utils.hpp"
+#include "vulkan/surface/CthSwapchain.hpp"
+#include "vulkan/utility/CthVkUtils.hpp"
+
+#include <cth/cth_log.hpp>
+
+#include <algorithm>
+#include <array>
+#include <utility>
+
+
+
+namespace cth {
+VkCommandBuffer OffscreenRenderer::beginFrame() {
+    CTH_ERR(frameStarted, "more than one frame started")
+        throw details->exception();
+
+    Target& target = targets[currentFrameIndex];
+    device->timeline()->wait(target.value);
+
+    frameStarted = true;
+    commandMemory->reset(currentFrameIndex);
+    frameMemory->reset(currentFrameIndex);
+    frameCommandBuffer = commandMemory->allocate();
+
+    const auto buffer = commandBuffer();
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    const VkResult beginResult = vkBeginCommandBuffer(buffer, &beginInfo);
+    CTH_STABLE_ERR(beginResult != VK_SUCCESS, "failed to begin command buffer")
+        throw cth::except::vk_result_exception{beginResult, details->exception()};
+
+    //the results of the frame that last used the slot are resolved here
+    profiler->beginFrame(buffer, currentFrameIndex);
+    frameQuery = profiler->begin(buffer, profiler->scope(GPU_FRAME_SCOPE));
+
+    return buffer;
+}
+void OffscreenRenderer::endFrame() {
+    CTH_ERR(!frameStarted, "no frame active") throw details->exception();
+
+    Target& target = targets[currentFrameIndex];
+    const auto buffer = commandBuffer();
+
+    if(target.readbackBuffer != nullptr) recordReadback(buffer, target);
+    profiler->end(buffer, frameQuery);
+
+    const VkResult recordResult = vkEndCommandBuffer(buffer);
+    CTH_STABLE_ERR(recordResult != VK_SUCCESS, "failed to record command buffer")
+        throw cth::except::vk_result_exception{recordResult, details->exception()};
+
+    //uploads recorded during the frame must execute before the frame reads them
+    device->uploadQueue()->submit();
+    device->uploadQueue()->update();
+
+    const Timeline::Value value = device->timeline()->reserve();
+    submit(buffer, value);
+    target.value = value;
+    lastSubmitted = value;
+
+    device->deletionQueue()->next();
+
+    frameStarted = false;
+    ++currentFrameIndex %= config.framesInFlight;
+}
+
+void OffscreenRenderer::beginRenderPass(VkCommandBuffer command_buffer) const {
+    CTH_ERR(!frameStarted, "no frame started") throw details->exception();
+    CTH_ERR(command_buffer != commandBuffer(), "renderPass already started")
+        throw details->exception();
+
+    VkRenderPassBeginInfo renderPassInfo{};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    renderPassInfo.renderPass = renderPass;
+    renderPassInfo.framebuffer = targets[currentFrameIndex].framebuffer;
+    renderPassInfo.renderArea.offset = {0, 0};
+    renderPassInfo.renderArea.extent = config.extent;
+
+    //the resolve attachment is not cleared
+    array<VkClearValue, 2> clearValues{};
+    clearValues[0].color = {0, 0, 0, 1};
+    clearValues[1].depthStencil = {1.0f, 0};
+    renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+    renderPassInfo.pClearValues = clearValues.data();
+
+    vkCmdBeginRenderPass(command_buffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+    VkViewport viewport;
+    viewport.x = 0;
+    viewport.y = 0;
+    viewport.width = static_cast<float>(config.extent.width);
+    viewport.height = static_cast<float>(config.extent.height);
+    viewport.minDepth = 0;
+    viewport.maxDepth = 1.0f;
+    const VkRect2D scissor{{0, 0}, config.extent};
+    vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+    vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+}
+void OffscreenRenderer::endRenderPass(VkCommandBuffer command_buffer) const {
+    CTH_ERR(!frameStarted, "no frame active") throw details->exception();
+    CTH_ERR(command_buffer != commandBuffer(), "only one command buffer allowed")
+        throw details->exception();
+
+    vkCmdEndRenderPass(command_buffer);
+}
+
+span<const char> OffscreenRenderer::readback() const {
+    CTH_STABLE_ERR(!config.readback, "readback disabled") throw details->exception();
+    CTH_STABLE_ERR(lastSubmitted == 0, "no frame submitted") throw details->exception();
+
+    const uint32_t lastFrame = (currentFrameIndex + config.framesInFlight - 1) % config.framesInFlight;
+    const Target& target = targets[lastFrame];
+
+    device->timeline()->wait(target.value);
+
+    const VkResult invalidateResult = target.readbackBuffer->invalidate();
+    CTH_STABLE_ERR(invalidateResult != VK_SUCCESS, "failed to invalidate readback memory")
+        throw cth::except::vk_result_exception{invalidateResult, details->exception()};
+
+    return target.readbackBuffer->mappedMemory();
+}
+
+VkCommandBuffer OffscreenRenderer::commandBuffer() const {
+    CTH_ERR(!frameStarted, "no frame active") throw details->exception();
+    return frameCommandBuffer;
+}
+uint32_t OffscreenRenderer::frameIndex() const {
+    CTH_ERR(!frameStarted, "no frame active") throw details->exception();
+    return currentFrameIndex;
+}
+
+
+VkDeviceSize OffscreenRenderer::texelSize(const VkFormat format) {
+    switch(format) {
+        case VK_FORMAT_R8G8B8A8_UNORM:
+        case VK_FORMAT_R8G8B8A8_SRGB:
+        case VK_FORMAT_B8G8R8A8_UNORM:
+        case VK_FORMAT_B8G8R8A8_SRGB:
+        case VK_FORMAT_A2B10G10R10_UNORM_PACK32:
+            return 4;
+        case VK_FORMAT_R16G16B16A16_SFLOAT:
+            return 8;
+        case VK_FORMAT_R32G32B32A32_SFLOAT:
+            return 16;
+        default:
+            CTH_STABLE_ERR(true, "format not supported for readback") {
+                details->add("format: {}", static_cast<uint32_t>(format));
+                throw details->exception();
+            }
+            std::unreachable();
+    }
+}
+VkImageCreateInfo OffscreenRenderer::createImageInfo(const VkFormat format, const VkSampleCountFlagBits samples,
+    const VkImageUsageFlags usage) const {
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.extent.width = config.extent.width;
+    imageInfo.extent.height = config.extent.height;
+    imageInfo.extent.depth = 1;
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 1;
+    imageInfo.format = format;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    imageInfo.usage = usage;
+    imageInfo.samples = samples;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.flags = 0;
+
+    return imageInfo;
+}
+VkFormat OffscreenRenderer::findDepthFormat() const {
+    return device->findSupportedFormat(
+        {VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT},
+        VK_IMAGE_TILING_OPTIMAL,
+        VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
+}
+
+void OffscreenRenderer::createRenderPass() {
+    const bool msaa = config.samples != VK_SAMPLE_COUNT_1_BIT;
+
+    //the color target is stored and left in transfer src layout for the readback
+    VkAttachmentDescription colorAttachment{};
+    colorAttachment.format = config.colorFormat;
+    colorAttachment.samples = config.samples;
+    colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    colorAttachment.storeOp = msaa ? VK_ATTACHMENT_STORE_OP_DONT_CARE : VK_ATTACHMENT_STORE_OP_STORE;
+    colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    colorAttachment.finalLayout = msaa ? VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+    VkAttachmentDescription depthAttachment{};
+    depthAttachment.format = depthFormat;
+    depthAttachment.samples = config.samples;
+    depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+    VkAttachmentDescription resolveAttachment{};
+    resolveAttachment.format = config.colorFormat;
+    resolveAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+    resolveAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    resolveAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    resolveAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    resolveAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    resolveAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    resolveAttachment.finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+    constexpr VkAttachmentReference colorAttachmentRef{0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+    constexpr VkAttachmentReference depthAttachmentRef{1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL};
+    constexpr VkAttachmentReference resolveAttachmentRef{2, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+
+    SubpassDescription subpassDescription(VK_PIPELINE_BIND_POINT_GRAPHICS, vector{colorAttachmentRef}, depthAttachmentRef,
+        msaa ? vector{resolveAttachmentRef} : vector<VkAttachmentReference>{});
+    if(!msaa) subpassDescription.ptr()->pResolveAttachments = nullptr;
+
+    array<VkSubpassDependency, 2> dependencies{};
+    dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+    dependencies[0].dstSubpass = 0;
+    dependencies[0].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+        VK_PIPELINE_STAGE_TRANSFER_BIT;
+    dependencies[0].srcAccessMask = 0;
+    dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+    dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+    //makes the color target available to the readback copy
+    dependencies[1].srcSubpass = 0;
+    dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+    dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    dependencies[1].dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    dependencies[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+    const array<VkAttachmentDescription, 3> attachments{colorAttachment, depthAttachment, resolveAttachment};
+
+    VkRenderPassCreateInfo renderPassInfo{};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    renderPassInfo.attachmentCount = msaa ? 3u : 2u;
+    renderPassInfo.pAttachments = attachments.data();
+    renderPassInfo.subpassCount = 1;
+    renderPassInfo.pSubpasses = subpassDescription.ptr();
+    renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+    renderPassInfo.pDependencies = dependencies.data();
+
+    const VkResult createResult = vkCreateRenderPass(device->get(), &renderPassInfo, HostAllocator::callbacks(HostAllocator::CATEGORY_SWAPCHAIN),
+        &renderPass);
+    CTH_STABLE_ERR(createResult != VK_SUCCESS, "failed to create offscreen render pass")
+        throw cth::except::vk_result_exception{createResult, details->exception()};
+    if constexpr(ResourceTracker::ENABLED) device->resourceTracker()->add(ResourceTracker::TYPE_RENDER_PASS, renderPass, 0, "Offscreen");
+}
+void OffscreenRenderer::createTargets() {
+    const bool msaa = config.samples != VK_SAMPLE_COUNT_1_BIT;
+    const VkDeviceSize readbackSize = config.readback ?
+        static_cast<VkDeviceSize>(config.extent.width) * config.extent.height * texelSize(config.colorFormat) : 0;
+
+    const auto colorInfo = createImageInfo(config.colorFormat, VK_SAMPLE_COUNT_1_BIT,
+        VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
+    const auto msaaInfo = createImageInfo(config.colorFormat, config.samples,
+        VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT);
+    const auto depthInfo = createImageInfo(depthFormat, config.samples,
+        VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT);
+
+    targets.resize(config.framesInFlight);
+
+    for(auto& target : targets) {
+        device->createImageWithInfo(colorInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, target.colorImage, target.colorMemory);
+        target.colorView = Swapchain::createImageView(device->get(), target.colorImage, config.colorFormat);
+
+        if(msaa) {
+            device->createImageWithInfo(msaaInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, target.msaaImage, target.msaaMemory);
+            target.msaaView = Swapchain::createImageView(device->get(), target.msaaImage, config.colorFormat);
+        }
+
+        device->createImageWithInfo(depthInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, target.depthImage, target.depthMemory);
+        target.depthView = Swapchain::createImageView(device->get(), target.depthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT);
+
+        if constexpr(ResourceTracker::ENABLED) {
+            device->resourceTracker()->add(ResourceTracker::TYPE_IMAGE, target.colorImage, target.colorMemory.size, "Offscreen color");
+            if(msaa) device->resourceTracker()->add(ResourceTracker::TYPE_IMAGE, target.msaaImage, target.msaaMemory.size, "Offscreen msaa");
+            device->resourceTracker()->add(ResourceTracker::TYPE_IMAGE, target.depthImage, target.depthMemory.size, "Offscreen depth");
+            device->resourceTracker()->add(ResourceTracker::TYPE_IMAGE_VIEW, target.colorView, 0, "Offscreen color");
+            if(msaa) device->resourceTracker()->add(ResourceTracker::TYPE_IMAGE_VIEW, target.msaaView, 0, "Offscreen msaa");
+            device->resourceTracker()->add(ResourceTracker::TYPE_IMAGE_VIEW, target.depthView, 0, "Offscreen depth");
+        }
+
+        const array<VkImageView, 3> attachments = msaa ? array{target.msaaView, target.depthView, target.colorView} :
+            array{target.colorView, target.depthView, VkImageView{VK_NULL_HANDLE}};
+
+        VkFramebufferCreateInfo framebufferInfo{};
+        framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        framebufferInfo.renderPass = renderPass;
+        framebufferInfo.attachmentCount = msaa ? 3u : 2u;
+        framebufferInfo.pAttachments = attachments.data();
+        framebufferInfo.width = config.extent.width;
+        framebufferInfo.height = config.extent.height;
+        framebufferInfo.layers = 1;
+
+        const VkResult createResult = vkCreateFramebuffer(device->get(), &framebufferInfo, HostAllocator::callbacks(HostAllocator::CATEGORY_SWAPCHAIN),
+            &target.framebuffer);
+        CTH_STABLE_ERR(createResult != VK_SUCCESS, "failed to create offscreen framebuffer")
+            throw cth::except::vk_result_exception{createResult, details->exception()};
+        if constexpr(ResourceTracker::ENABLED) device->resourceTracker()->add(ResourceTracker::TYPE_FRAMEBUFFER, target.framebuffer, 0, "Offscreen");
+
+        if(config.readback)
+            target.readbackBuffer = make_unique<DefaultBuffer>(device, readbackSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, 1, DefaultBuffer::FLAG_PERSISTENT_MAP); /*host cached is preferred for transfer dst buffers*/
+    }
+}
+void OffscreenRenderer::createCommandAllocator() {
+    commandMemory = make_unique<CommandAllocator>(device, device->queueFamilies().graphicsFamilyIndex, config.framesInFlight);
+}
+void OffscreenRenderer::createFrameAllocator() {
+    frameMemory = make_unique<FrameAllocator>(device, FRAME_ALLOCATOR_SIZE, config.framesInFlight);
+}
+void OffscreenRenderer::createGpuProfiler() {
+    profiler = make_unique<GpuProfiler>(device, config.framesInFlight);
+}
+
+void OffscreenRenderer::recordReadback(VkCommandBuffer command_buffer, const Target& target) const {
+    //the render pass left the color target in transfer src layout
+    VkBufferImageCopy region{};
+    region.bufferOffset = 0;
+    region.bufferRowLength = 0;
+    region.bufferImageHeight = 0;
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount = 1;
+    region.imageOffset = {0, 0, 0};
+    region.imageExtent = {config.extent.width, config.extent.height, 1};
+
+    vkCmdCopyImageToBuffer(command_buffer, target.colorImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, target.readbackBuffer->get(), 1, &region);
+
+    VkBufferMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = target.readbackBuffer->get();
+    barrier.offset = 0;
+    barrier.size = VK_WHOLE_SIZE;
+
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+}
+void OffscreenRenderer::submit(VkCommandBuffer command_buffer, const Timeline::Value value) const {
+    const VkSemaphore timelineSemaphore = device->timeline()->get();
+
+    VkTimelineSemaphoreSubmitInfo timelineInfo{};
+    timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timelineInfo.signalSemaphoreValueCount = 1;
+    timelineInfo.pSignalSemaphoreValues = &value;
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.pNext = &timelineInfo;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &command_buffer;
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores = &timelineSemaphore;
+
+    const VkResult submitResult = vkQueueSubmit(device->graphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE);
+    CTH_STABLE_ERR(submitResult != VK_SUCCESS, "failed to submit offscreen frame")
+        throw cth::except::vk_result_exception{submitResult, details->exception()};
+}
+
+void OffscreenRenderer::destroyTargets() {
+    DeletionQueue* deletionQueue = device->deletionQueue();
+
+    for(auto& target : targets) {
+        if constexpr(ResourceTracker::ENABLED) {
+            device->resourceTracker()->remove(ResourceTracker::TYPE_IMAGE, target.colorImage);
+            if(target.msaaImage != VK_NULL_HANDLE) device->resourceTracker()->remove(ResourceTracker::TYPE_IMAGE, target.msaaImage);
+            device->resourceTracker()->remove(ResourceTracker::TYPE_IMAGE, target.depthImage);
+        }
+
+        deletionQueue->enqueue(DeletionQueue::TYPE_FRAMEBUFFER, target.framebuffer);
+
+        deletionQueue->enqueue(DeletionQueue::TYPE_IMAGE_VIEW, target.colorView);
+        deletionQueue->enqueue(DeletionQueue::TYPE_IMAGE, target.colorImage);
+        deletionQueue->enqueue(target.colorMemory);
+
+        deletionQueue->enqueue(DeletionQueue::TYPE_IMAGE_VIEW, target.msaaView);
+        deletionQueue->enqueue(DeletionQueue::TYPE_IMAGE, target.msaaImage);
+        deletionQueue->enqueue(target.msaaMemory);
+
+        deletionQueue->enqueue(DeletionQueue::TYPE_IMAGE_VIEW, target.depthView);
+        deletionQueue->enqueue(DeletionQueue::TYPE_IMAGE, target.depthImage);
+        deletionQueue->enqueue(target.depthMemory);
+    }
+    targets.clear();
+
+    deletionQueue->enqueue(DeletionQueue::TYPE_RENDER_PASS, renderPass);
+    deletionQueue->next();
+}
+
+
+OffscreenRenderer::OffscreenRenderer(Device* device, const OffscreenConfig& offscreen_config) : device{device}, config{offscreen_config} {
+    CTH_STABLE_ERR(config.framesInFlight == 0 || config.framesInFlight > Swapchain::MAX_FRAMES_IN_FLIGHT, "frames in flight out of range") {
+        details->add("frames in flight: {0}, max: {1}", config.framesInFlight, Swapchain::MAX_FRAMES_IN_FLIGHT);
+        throw details->exception();
+    }
+
+    const auto maxSamples = device->evaluateMaxUsableSampleCount();
+    config.samples = static_cast<VkSampleCountFlagBits>(std::min<uint32_t>(config.samples, maxSamples));
+    depthFormat = findDepthFormat();
+
+    createRenderPass();
+    createTargets();
+    createCommandAllocator();
+    createFrameAllocator();
+    createGpuProfiler();
+
+    cth::log::msg<except::INFO>("offscreen renderer: {0}x{1}, {2} frames in flight, {3} samples{4}", config.extent.width, config.extent.height,
+        config.framesInFlight, static_cast<uint32_t>(config.samples), config.readback ? ", readback" : "");
+}
+OffscreenRenderer::~OffscreenRenderer() {
+    //the command pools can only be destroyed once the last frame finished
+    device->timeline()->wait(lastSubmitted);
+
+    profiler = nullptr;
+    frameMemory = nullptr;
+    commandMemory = nullptr;
+
+    destroyTargets();
+}
+}
@@ -0,0 +1,184 @@
+#pragma once
+#include "vulkan/base/CthTimeline.hpp"
+#include "vulkan/memory/allocator/CthMemoryAllocator.hpp"
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <vector>
+
+
+namespace cth {
+class Device;
+class CommandAllocator;
+class GpuProfiler;
+class DefaultBuffer;
+class FrameAllocator;
+
+using namespace std;
+
+/**
+ * \brief options of the offscreen targets, fixed for the lifetime of the renderer
+ */
+struct OffscreenConfig {
+    VkExtent2D extent{1280, 720};
+    VkFormat colorFormat = VK_FORMAT_R8G8B8A8_UNORM;
+    VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT; /*clamped to the device limits*/
+    uint32_t framesInFlight = 2; /*[1, Swapchain::MAX_FRAMES_IN_FLIGHT]*/
+    bool readback = false; /*copies every frame into a host visible buffer, see OffscreenRenderer::readback()*/
+};
+
+/**
+ * \brief renders into a ring of offscreen color and depth targets, one per frame in flight
+ * \note same frame api as Renderer, works on headless devices without a window or swapchain
+ * \note frames are paced by the devices timeline
+ */
+class OffscreenRenderer {
+public:
+    /**
+     * \brief waits for the target of the frame slot, resets its command pools and frame allocator region
+     * \throws cth::except::vk_result_exception result of vkBeginCommandBuffer()
+     */
+    VkCommandBuffer beginFrame();
+    /**
+     * \brief submits the devices upload queue and the frame, records the readback copy if enabled
+     * \throws cth::except::vk_result_exception result of vkEndCommandBuffer()
+     * \throws cth::except::vk_result_exception result of vkQueueSubmit()
+     * \throws cth::except::vk_result_exception result of UploadQueue::submit()
+     */
+    void endFrame();
+
+    void beginRenderPass(VkCommandBuffer command_buffer) const;
+    void endRenderPass(VkCommandBuffer command_buffer) const;
+
+    /**
+     * \brief blocks until the last submitted frame finished
+     * \return tightly packed rows of the color target in OffscreenConfig::colorFormat,
+     * valid until framesInFlight() more frames were begun
+     * \throws cth::except::default_exception reason: readback disabled
+     * \throws cth::except::default_exception reason: no frame submitted
+     * \throws cth::except::vk_result_exception result of vkInvalidateMappedMemoryRanges()
+     */
+    [[nodiscard]] span<const char> readback() const;
+
+private:
+    struct Target {
+        VkImage colorImage = VK_NULL_HANDLE;
+        VkImageView colorView = VK_NULL_HANDLE;
+        MemoryAllocation colorMemory{};
+
+        VkImage msaaImage = VK_NULL_HANDLE; /*VK_NULL_HANDLE -> no msaa*/
+        VkImageView msaaView = VK_NULL_HANDLE;
+        MemoryAllocation msaaMemory{};
+
+        VkImage depthImage = VK_NULL_HANDLE;
+        VkImageView depthView = VK_NULL_HANDLE;
+        MemoryAllocation depthMemory{};
+
+        VkFramebuffer framebuffer = VK_NULL_HANDLE;
+        unique_ptr<DefaultBuffer> readbackBuffer = nullptr; /*nullptr -> readback disabled*/
+        Timeline::Value value = 0; /*timeline value of the last frame rendered into the target*/
+    };
+
+    /**
+     * \return bytes per texel of the supported readback formats
+     * \throws cth::except::default_exception reason: format not supported for readback
+     */
+    [[nodiscard]] static VkDeviceSize texelSize(VkFormat format);
+
+    [[nodiscard]] VkImageCreateInfo createImageInfo(VkFormat format, VkSampleCountFlagBits samples, VkImageUsageFlags usage) const;
+    [[nodiscard]] VkFormat findDepthFormat() const;
+    /**
+     * \throws cth::except::vk_result_exception result of vkCreateRenderPass()
+     */
+    void createRenderPass();
+    /**
+     * \throws cth::except::vk_result_exception result of vkCreateFramebuffer()
+     */
+    void createTargets();
+    void createCommandAllocator();
+    void createFrameAllocator();
+    /**
+     * \throws cth::except::vk_result_exception result of vkCreateQueryPool()
+     */
+    void createGpuProfiler();
+    /**
+     * \brief copies the color target into the readback buffer
+     */
+    void recordReadback(VkCommandBuffer command_buffer, const Target& target) const;
+    /**
+     * \throws cth::except::vk_result_exception result of vkQueueSubmit()
+     */
+    void submit(VkCommandBuffer command_buffer, Timeline::Value value) const;
+
+    void destroyTargets();
+
+
+    Device* device;
+    OffscreenConfig config;
+    VkFormat depthFormat = VK_FORMAT_UNDEFINED;
+
+    VkRenderPass renderPass = VK_NULL_HANDLE;
+    vector<Target> targets;
+    unique_ptr<CommandAllocator> commandMemory;
+    unique_ptr<FrameAllocator> frameMemory;
+    unique_ptr<GpuProfiler> profiler;
+    VkCommandBuffer frameCommandBuffer = VK_NULL_HANDLE;
+    uint32_t frameQuery = 0; /*GpuProfiler query of the GPU_FRAME_SCOPE*/
+
+    uint32_t currentFrameIndex = 0;
+    Timeline::Value lastSubmitted = 0;
+    bool frameStarted = false;
+
+public:
+    /**
+     * \throws cth::except::default_exception reason: frames in flight out of range
+     * \throws cth::except::default_exception reason: format not supported for readback
+     */
+    explicit OffscreenRenderer(Device* device, const OffscreenConfig& offscreen_config = {});
+    ~OffscreenRenderer();
+
+    static constexpr VkDeviceSize FRAME_ALLOCATOR_SIZE = 4ull * 1024 * 1024;
+    static constexpr string_view GPU_FRAME_SCOPE = "frame";
+
+    [[nodiscard]] VkRenderPass getRenderPass() const { return renderPass; }
+    [[nodiscard]] VkExtent2D extent() const { return config.extent; }
+    [[nodiscard]] float screenRatio() const { return static_cast<float>(config.extent.width) / static_cast<float>(config.extent.height); }
+    [[nodiscard]] bool frameInProgress() const { return frameStarted; }
+    [[nodiscard]] VkCommandBuffer commandBuffer() const;
+    /**
+     * \return [0, framesInFlight())
+     */
+    [[nodiscard]] uint32_t frameIndex() const;
+    [[nodiscard]] uint32_t framesInFlight() const { return config.framesInFlight; }
+    [[nodiscard]] VkSampleCountFlagBits msaaSampleCount() const { return config.samples; }
+    /**
+     * \return timeline value of the last submitted frame, query or wait on it with Device::timeline()
+     */
+    [[nodiscard]] Timeline::Value submittedFrame() const { return lastSubmitted; }
+    /**
+     * \return per frame linear allocator, allocations stay valid until the frame finished
+     */
+    [[nodiscard]] FrameAllocator* frameAllocator() const { return frameMemory.get(); }
+    /**
+     * \return per thread and frame command pools of the graphics family, buffers stay valid until the frame slot is reused
+     */
+    [[nodiscard]] CommandAllocator* commandAllocator() const { return commandMemory.get(); }
+    /**
+     * \return timestamp profiler of the frames, every frame is measured as GPU_FRAME_SCOPE
+     */
+    [[nodiscard]] GpuProfiler* gpuProfiler() const { return profiler.get(); }
+    /**
+     * \return color target of the frame slot, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL after the frame finished
+     */
+    [[nodiscard]] VkImage colorImage(const uint32_t frame_index) const { return targets[frame_index].colorImage; }
+
+    OffscreenRenderer(const OffscreenRenderer&) = delete;
+    OffscreenRenderer& operator=(const OffscreenRenderer&) = delete;
+    OffscreenRenderer(OffscreenRenderer&&) = delete;
+    OffscreenRenderer& operator=(OffscreenRenderer&&) = delete;
+};
+}
@@ -1,13 +1,21 @@
 #include "CthRenderer.hpp"
 
+#include "core/CthCpuProfiler.hpp"
+#include "core/CthJobSystem.hpp"
 #include "interface/user/HlcCamera.hpp"
+#include "vulkan/base/CthCommandAllocator.hpp"
+#include "vulkan/base/CthDeletionQueue.hpp"
 #include "vulkan/base/CthDevice.hpp"
+#include "vulkan/debug/CthGpuProfiler.hpp"
+#include "vulkan/memory/buffer/CthFrameAllocator.hpp"
+#include "vulkan/memory/transfer/CthUploadQueue.hpp"
 #include "vulkan/surface/CthWindow.hpp"
 #include "vulkan/utility/CthVkUtils.hpp"
 
 #include <cth/cth_log.hpp>
 
 #include <array>
+#include <chrono>
 
 
 
@@ -20,15 +28,27 @@ VkExtent2D Renderer::minimizedState() const {
     }
     return extent;
 }
+void Renderer::setViewport(VkCommandBuffer command_buffer) const {
+    VkViewport viewport;
+    viewport.x = 0;
+    viewport.y = 0;
+    viewport.width = static_cast<float>(swapchain->getSwapchainExtent().width);
+    viewport.height = static_cast<float>(swapchain->getSwapchainExtent().height);
+    viewport.minDepth = 0;
+    viewport.maxDepth = 1.0f;
+    const VkRect2D scissor{{0, 0}, swapchain->getSwapchainExtent()};
+    vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+    vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+}
 
 
 void Renderer::recreateSwapchain() {
+    const CpuProfiler::Zone zone{"recreate swapchain"};
     VkExtent2D windowExtent = minimizedState();
 
-    vkDeviceWaitIdle(device->get());
-
+    //the old swapchain hands its resources to the deletion queue, frames in flight keep using them
     if(swapchain == nullptr) {
-        swapchain = make_unique<Swapchain>(device, window, windowExtent);
+        swapchain = make_unique<Swapchain>(device, window, windowExtent, swapchainConfig);
         return;
     }
 
@@ -40,41 +60,57 @@ void Renderer::recreateSwapchain() {
     CTH_STABLE_ERR(!noChange, "depth or image format changed")
         throw details->exception();
 }
+void Renderer::updateSwapchain(const VkResult result) {
+    const bool outOfDate = result == VK_ERROR_OUT_OF_DATE_KHR;
+    if(!outOfDate && result != VK_SUBOPTIMAL_KHR && !window->windowResized()) return;
+
+    //recreating on every resize event of a drag is wasted work, frames are skipped until the resize settled
+    const auto sinceResize = chrono::steady_clock::now() - window->lastResize();
+    if(sinceResize < RESIZE_DEBOUNCE) {
+        //an out of date swapchain can't render, sleep instead of spinning on skipped frames
+        if(outOfDate) glfwWaitEventsTimeout(chrono::duration<double>(RESIZE_DEBOUNCE - sinceResize).count());
+        return;
+    }
+
+    recreateSwapchain();
+    camera->correctViewRatio(screenRatio());
+    window->resetWindowResized();
+}
 VkCommandBuffer Renderer::commandBuffer() const {
     CTH_ERR(!frameStarted, "no frame active") throw details->exception();
-    return commandBuffers[currentFrameIndex];
+    return frameCommandBuffer;
 }
 uint32_t Renderer::frameIndex() const {
     CTH_ERR(!frameStarted, "no frame active") throw details->exception();
     return currentFrameIndex;
 }
 
-void Renderer::createCommandBuffers() {
-    commandBuffers.resize(swapchain->MAX_FRAMES_IN_FLIGHT);
-    VkCommandBufferAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    allocInfo.commandPool = device->getCommandPool();
-    allocInfo.commandBufferCount = static_cast<uint32_t>(commandBuffers.size());
-
-    const VkResult allocResult = vkAllocateCommandBuffers(device->get(), &allocInfo, commandBuffers.data());
-
-    CTH_STABLE_ERR(allocResult != VK_SUCCESS, "Vk: failed to allocate command buffers")
-        throw cth::except::vk_result_exception{allocResult, details->exception()};
-};
-void Renderer::freeCommandBuffers() {
-    vkFreeCommandBuffers(device->get(), device->getCommandPool(), static_cast<uint32_t>(commandBuffers.size()), commandBuffers.data());
-    commandBuffers.clear();
+void Renderer::createCommandAllocator() {
+    commandMemory = make_unique<CommandAllocator>(device, device->queueFamilies().graphicsFamilyIndex, swapchainConfig.framesInFlight);
+}
+void Renderer::createFrameAllocator() {
+    frameMemory = make_unique<FrameAllocator>(device, FRAME_ALLOCATOR_SIZE, swapchainConfig.framesInFlight);
+}
+void Renderer::createJobSystem() { jobSystem = make_unique<JobSystem>(); }
+void Renderer::createGpuProfiler() {
+    profiler = make_unique<GpuProfiler>(device, swapchainConfig.framesInFlight);
 }
 
 VkCommandBuffer Renderer::beginFrame() {
     CTH_ERR(frameStarted, "more than one frame started")
         throw details->exception();
 
-    const VkResult nextImageResult = swapchain->acquireNextImage(&currentImageIndex);
+    //the previous frame ends here, it includes everything the app did between the frames
+    CpuProfiler::nextFrame();
+
+    VkResult nextImageResult;
+    {
+        const CpuProfiler::Zone zone{"acquire"};
+        nextImageResult = swapchain->acquireNextImage(&currentImageIndex);
+    }
 
     if(nextImageResult == VK_ERROR_OUT_OF_DATE_KHR) {
-        recreateSwapchain();
+        updateSwapchain(nextImageResult);
         return nullptr;
     }
 
@@ -83,41 +119,62 @@ VkCommandBuffer Renderer::beginFrame() {
 
     frameStarted = true;
 
+    //acquireNextImage() waited for the timeline value of this frame slot
+    commandMemory->reset(currentFrameIndex);
+    frameMemory->reset(currentFrameIndex);
+    frameCommandBuffer = commandMemory->allocate();
+
     const auto buffer = commandBuffer();
     VkCommandBufferBeginInfo beginInfo{};
     beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 
     const VkResult beginResult = vkBeginCommandBuffer(buffer, &beginInfo);
     CTH_STABLE_ERR(beginResult != VK_SUCCESS, "failed to begin command buffer")
         throw cth::except::vk_result_exception{beginResult, details->exception()};
 
+    //the results of the frame that last used the slot are resolved here
+    profiler->beginFrame(buffer, currentFrameIndex);
+    frameQuery = profiler->begin(buffer, profiler->scope(GPU_FRAME_SCOPE));
+
+    //closed by endFrame()
+    CpuProfiler::begin("record");
     return buffer;
 }
 void Renderer::endFrame() {
     CTH_ERR(!frameStarted, "no frame active") throw details->exception();
+    CpuProfiler::end();
 
     const auto buffer = commandBuffer();
+    profiler->end(buffer, frameQuery);
     const VkResult recordResult = vkEndCommandBuffer(buffer);
 
     CTH_STABLE_ERR(recordResult != VK_SUCCESS, "failed to record command buffer")
         throw cth::except::vk_result_exception{recordResult, details->exception()};
 
+    //uploads recorded during the frame must execute before the frame reads them
+    {
+        const CpuProfiler::Zone zone{"upload"};
+        device->uploadQueue()->submit();
+        device->uploadQueue()->update();
+    }
 
     const VkResult submitResult = swapchain->submitCommandBuffer(buffer, currentImageIndex);
 
-    if(submitResult == VK_ERROR_OUT_OF_DATE_KHR || submitResult == VK_SUBOPTIMAL_KHR || window->windowResized()) {
-        recreateSwapchain();
-        camera->correctViewRatio(screenRatio());
-        window->resetWindowResized();
-    } else
-        CTH_STABLE_ERR(submitResult != VK_SUCCESS, "failed to present swapchain image")
-            throw cth::except::vk_result_exception{submitResult, details->exception()};
+    CTH_STABLE_ERR(submitResult != VK_SUCCESS && submitResult != VK_SUBOPTIMAL_KHR && submitResult != VK_ERROR_OUT_OF_DATE_KHR,
+        "failed to present swapchain image")
+        throw cth::except::vk_result_exception{submitResult, details->exception()};
+
+    updateSwapchain(submitResult);
+
+    //everything enqueued until now was used by this frame at the latest
+    device->deletionQueue()->next();
 
     frameStarted = false;
-    ++currentFrameIndex %= Swapchain::MAX_FRAMES_IN_FLIGHT;
+    ++currentFrameIndex %= swapchainConfig.framesInFlight;
 }
 
-void Renderer::beginSwapchainRenderPass(VkCommandBuffer command_buffer) const {
+void Renderer::beginSwapchainRenderPass(VkCommandBuffer command_buffer, const VkSubpassContents contents) {
     CTH_ERR(!frameStarted, "no frame started") throw details->exception();
     CTH_ERR(command_buffer != commandBuffer(), "renderPass already started")
         throw details->exception();
@@ -135,19 +192,11 @@ void Renderer::beginSwapchainRenderPass(VkCommandBuffer command_buffer) const {
     renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
     renderPassInfo.pClearValues = clearValues.data();
 
-    vkCmdBeginRenderPass(command_buffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-
-    VkViewport viewport;
-    viewport.x = 0;
-    viewport.y = 0;
-    viewport.width = static_cast<float>(swapchain->getSwapchainExtent().width);
-    viewport.height = static_cast<float>(swapchain->getSwapchainExtent().height);
-    viewport.minDepth = 0;
-    viewport.maxDepth = 1.0f;
-    const VkRect2D scissor{{0, 0}, swapchain->getSwapchainExtent()};
-    vkCmdSetViewport(command_buffer, 0, 1, &viewport);
-    vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+    vkCmdBeginRenderPass(command_buffer, &renderPassInfo, contents);
+    passContents = contents;
 
+    //secondaries don't inherit dynamic state, beginSecondary() sets it
+    if(contents == VK_SUBPASS_CONTENTS_INLINE) setViewport(command_buffer);
 }
 void Renderer::endSwapchainRenderPass(VkCommandBuffer command_buffer) const {
     CTH_ERR(!frameStarted, "no frame active") throw details->exception();
@@ -157,9 +206,73 @@ void Renderer::endSwapchainRenderPass(VkCommandBuffer command_buffer) const {
     vkCmdEndRenderPass(command_buffer);
 }
 
-Renderer::Renderer(Device* device, Camera* camera, Window* window) : device{device}, camera{camera}, window(window), currentImageIndex{0} {
+void Renderer::recordSecondaries(const uint32_t secondary_count, const function<void(VkCommandBuffer, uint32_t)>& record, JobSystem* jobs) const {
+    vector<VkCommandBuffer> secondaries(secondary_count);
+
+    //every secondary is allocated, recorded and ended on the same thread
+    const auto recordSecondary = [this, &secondaries, &record](const uint32_t index) {
+        const CpuProfiler::Zone zone{"record secondary"};
+        secondaries[index] = beginSecondary();
+        record(secondaries[index], index);
+        endSecondary(secondaries[index]);
+    };
+
+    //every recording thread gets its own command pools, only the persistent workers of a job system may record in parallel
+    (jobs != nullptr ? jobs : jobSystem.get())->parallelFor(secondary_count, recordSecondary, 1);
+
+    executeSecondaries(secondaries);
+}
+VkCommandBuffer Renderer::beginSecondary() const {
+    CTH_ERR(!frameStarted, "no frame active") throw details->exception();
+    CTH_ERR(passContents != VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS, "render pass not started for secondaries")
+        throw details->exception();
+
+    const VkCommandBuffer secondary = commandMemory->allocate(VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+
+    VkCommandBufferInheritanceInfo inheritanceInfo{};
+    inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritanceInfo.renderPass = swapchain->getRenderPass();
+    inheritanceInfo.subpass = 0;
+    inheritanceInfo.framebuffer = swapchain->getFrameBuffer(currentImageIndex);
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+    const VkResult beginResult = vkBeginCommandBuffer(secondary, &beginInfo);
+    CTH_STABLE_ERR(beginResult != VK_SUCCESS, "failed to begin secondary command buffer")
+        throw cth::except::vk_result_exception{beginResult, details->exception()};
+
+    setViewport(secondary);
+    return secondary;
+}
+void Renderer::endSecondary(VkCommandBuffer secondary) const {
+    const VkResult endResult = vkEndCommandBuffer(secondary);
+    CTH_STABLE_ERR(endResult != VK_SUCCESS, "failed to record secondary command buffer")
+        throw cth::except::vk_result_exception{endResult, details->exception()};
+}
+void Renderer::executeSecondaries(const span<const VkCommandBuffer> secondaries) const {
+    CTH_ERR(passContents != VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS, "render pass not started for secondaries")
+        throw details->exception();
+    if(secondaries.empty()) return;
+
+    vkCmdExecuteCommands(commandBuffer(), static_cast<uint32_t>(secondaries.size()), secondaries.data());
+}
+
+Renderer::Renderer(Device* device, Camera* camera, Window* window, const SwapchainConfig& swapchain_config) : device{device}, camera{camera},
+    window(window), swapchainConfig{swapchain_config}, currentImageIndex{0} {
     recreateSwapchain();
-    createCommandBuffers();
+    createCommandAllocator();
+    createFrameAllocator();
+    createJobSystem();
+    createGpuProfiler();
+}
+Renderer::~Renderer() {
+    vkDeviceWaitIdle(device->get());
+    profiler = nullptr;
+    jobSystem = nullptr;
+    frameMemory = nullptr;
+    commandMemory = nullptr;
 }
-Renderer::~Renderer() { freeCommandBuffers(); }
 }
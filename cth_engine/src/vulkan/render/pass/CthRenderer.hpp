@@ -3,8 +3,12 @@
 
 #include <vulkan/vulkan.h>
 
+#include <chrono>
 #include <cstdint>
+#include <functional>
 #include <memory>
+#include <span>
+#include <string_view>
 #include <vector>
 
 
@@ -12,25 +16,64 @@ namespace cth {
 class Device;
 class Window;
 class Camera;
+class CommandAllocator;
+class GpuProfiler;
+class JobSystem;
+class FrameAllocator;
 
 using namespace std;
 class Renderer {
 public:
     /**
+     * \brief waits for the frame slot, resets its command pools and frame allocator region
      * \throws cth::except::vk_result_exception result of  Swapchain::acquireNextImage()
      * \throws cth::except:vk_result_exception result of vkBeginCommandBuffer()
      */
     VkCommandBuffer beginFrame();
     /**
+     * \brief submits the devices upload queue and the frame, retires the objects enqueued into the deletion queue
      * \throws cth::except::vk_result_exception result of Swapchain::submitCommandBuffers()
      * \throws cth::except::vk_result_exception result of vkEndCommandBuffer()
+     * \throws cth::except::vk_result_exception result of UploadQueue::submit()
      */
     void endFrame();
 
-    void beginSwapchainRenderPass(VkCommandBuffer command_buffer) const;
+    /**
+     * \param contents VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS -> the pass is recorded in secondaries, see recordSecondaries()
+     */
+    void beginSwapchainRenderPass(VkCommandBuffer command_buffer, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
     void endSwapchainRenderPass(VkCommandBuffer command_buffer) const;
 
-    explicit Renderer(Device* device, Camera* camera, Window* window);
+    /**
+     * \brief records the active render pass in secondary_count secondaries and executes them in order
+     * \param record called once per secondary with its index, the secondary inherits the render pass and framebuffer
+     * \param jobs records in parallel on the workers of jobs and the calling thread, nullptr -> the job system of the renderer
+     * \note requires beginSwapchainRenderPass() with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS
+     * \note the first exception thrown by record is rethrown once every secondary finished recording
+     * \note record must not allocate from frameAllocator(), it is not thread safe, allocate before recording
+     */
+    void recordSecondaries(uint32_t secondary_count, const function<void(VkCommandBuffer, uint32_t)>& record, JobSystem* jobs = nullptr) const;
+    /**
+     * \brief allocates a secondary from the pool of the calling thread and begins it inside the active render pass
+     * \note thread safe, record and end the secondary on the calling thread, viewport and scissor are set
+     * \throws cth::except::vk_result_exception result of vkBeginCommandBuffer()
+     */
+    [[nodiscard]] VkCommandBuffer beginSecondary() const;
+    /**
+     * \note thread safe
+     * \throws cth::except::vk_result_exception result of vkEndCommandBuffer()
+     */
+    void endSecondary(VkCommandBuffer secondary) const;
+    /**
+     * \brief executes the ended secondaries in order inside the active render pass
+     */
+    void executeSecondaries(span<const VkCommandBuffer> secondaries) const;
+
+    /**
+     * \param swapchain_config frames in flight and present mode preference, fixed for the lifetime of the renderer
+     * \throws cth::except::default_exception reason: frames in flight out of range
+     */
+    explicit Renderer(Device* device, Camera* camera, Window* window, const SwapchainConfig& swapchain_config = {});
     ~Renderer();
 
     Renderer(const Renderer&) = delete;
@@ -42,38 +85,85 @@ private:
      * \return new window extent
      */
     VkExtent2D minimizedState() const;
+    void setViewport(VkCommandBuffer command_buffer) const;
 
+    void createCommandAllocator();
+    void createFrameAllocator();
+    void createJobSystem();
     /**
-     * \throws cth::except::vk_result_exception result of vkAllocateCommandBuffers()
+     * \throws cth::except::vk_result_exception result of vkCreateQueryPool()
      */
-    void createCommandBuffers();
-    void freeCommandBuffers();
+    void createGpuProfiler();
 
 
     /**
      * \throws cth::except::default_exception reason: depth or image format changed
      */
     void recreateSwapchain();
+    /**
+     * \brief recreates the swapchain if result or the window report it outdated and the last resize settled
+     * \param result of acquire or present
+     * \note fixes the view ratio and resets the window resize flag after recreating
+     * \note an out of date swapchain waits for window events until the resize settled, the frame is skipped
+     * \throws cth::except::default_exception reason: depth or image format changed
+     */
+    void updateSwapchain(VkResult result);
 
 
     Device* device;
     Camera* camera;
     Window* window;
 
+    SwapchainConfig swapchainConfig;
     unique_ptr<Swapchain> swapchain;
-    vector<VkCommandBuffer> commandBuffers;
+    unique_ptr<CommandAllocator> commandMemory;
+    unique_ptr<FrameAllocator> frameMemory;
+    unique_ptr<JobSystem> jobSystem;
+    unique_ptr<GpuProfiler> profiler;
+    VkCommandBuffer frameCommandBuffer = VK_NULL_HANDLE;
+    uint32_t frameQuery = 0; /*GpuProfiler query of the GPU_FRAME_SCOPE*/
 
     uint32_t currentImageIndex = 0;
     uint_fast8_t currentFrameIndex = 0;
     bool frameStarted = false;
+    VkSubpassContents passContents = VK_SUBPASS_CONTENTS_INLINE; /*of the active render pass*/
 
 public:
+    static constexpr VkDeviceSize FRAME_ALLOCATOR_SIZE = 4ull * 1024 * 1024;
+    static constexpr string_view GPU_FRAME_SCOPE = "frame";
+    /*minimum time since the last resize event before the swapchain is recreated*/
+    static constexpr chrono::milliseconds RESIZE_DEBOUNCE{100};
+
     [[nodiscard]] VkRenderPass swapchainRenderPass() const { return swapchain->getRenderPass(); }
     [[nodiscard]] float screenRatio() const { return swapchain->extentAspectRatio(); }
     [[nodiscard]] bool frameInProgress() const { return frameStarted; }
     [[nodiscard]] VkCommandBuffer commandBuffer() const;
+    /**
+     * \return [0, framesInFlight())
+     */
     [[nodiscard]] uint32_t frameIndex() const;
+    [[nodiscard]] uint32_t framesInFlight() const { return swapchainConfig.framesInFlight; }
     [[nodiscard]] VkSampleCountFlagBits msaaSampleCount() const { return swapchain->getMsaaSampleCount(); }
+    /**
+     * \return timeline value of the last submitted frame, query or wait on it with Device::timeline()
+     */
+    [[nodiscard]] Timeline::Value submittedFrame() const { return swapchain->lastFrameValue(); }
+    /**
+     * \return per frame linear allocator, allocations stay valid until the frame finished
+     */
+    [[nodiscard]] FrameAllocator* frameAllocator() const { return frameMemory.get(); }
+    /**
+     * \return per thread and frame command pools of the graphics family, buffers stay valid until the frame slot is reused
+     */
+    [[nodiscard]] CommandAllocator* commandAllocator() const { return commandMemory.get(); }
+    /**
+     * \return workers recordSecondaries() records on by default, may be shared with other per frame work
+     */
+    [[nodiscard]] JobSystem* jobs() const { return jobSystem.get(); }
+    /**
+     * \return timestamp profiler of the frames, every frame is measured as GPU_FRAME_SCOPE
+     */
+    [[nodiscard]] GpuProfiler* gpuProfiler() const { return profiler.get(); }
 
 };
 }
@@ -1,6 +1,11 @@
 #include "CthSwapchain.hpp"
 
+#include "core/CthCpuProfiler.hpp"
+#include "vulkan/base/CthDeletionQueue.hpp"
 #include "vulkan/base/CthDevice.hpp"
+#include "vulkan/base/CthTimeline.hpp"
+#include "vulkan/debug/CthResourceTracker.hpp"
+#include "vulkan/memory/allocator/CthHostAllocator.hpp"
 #include "vulkan/surface/CthWindow.hpp"
 #include "vulkan/utility/CthVkUtils.hpp"
 
@@ -26,7 +31,7 @@ VkImageView Swapchain::createImageView(const VkDevice& device, VkImage image, co
     viewInfo.subresourceRange.baseArrayLayer = 0;
     viewInfo.subresourceRange.layerCount = 1;
     VkImageView imageView;
-    if(vkCreateImageView(device, &viewInfo, nullptr, &imageView) != VK_SUCCESS) throw runtime_error("createImageView: failed to create image view");
+    if(vkCreateImageView(device, &viewInfo, HostAllocator::callbacks(HostAllocator::CATEGORY_RESOURCE), &imageView) != VK_SUCCESS) throw runtime_error("createImageView: failed to create image view");
     return imageView;
 }
 
@@ -38,7 +43,10 @@ VkFormat Swapchain::findDepthFormat() const {
 }
 
 VkResult Swapchain::acquireNextImage(uint32_t* image_index) const {
-    vkWaitForFences(device->get(), 1, &inFlightFences[currentFrame], VK_TRUE, std::numeric_limits<uint64_t>::max());
+    {
+        const CpuProfiler::Zone zone{"fence wait"};
+        device->timeline()->wait(frameValues[currentFrame]);
+    }
 
     const VkResult result = vkAcquireNextImageKHR(device->get(), vkSwapchain, std::numeric_limits<uint64_t>::max(),
         imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, image_index);
@@ -47,29 +55,58 @@ VkResult Swapchain::acquireNextImage(uint32_t* image_index) const {
 }
 
 
-VkResult Swapchain::submit(VkCommandBuffer command_buffer) const {
+VkResult Swapchain::submit(VkCommandBuffer command_buffer, const uint32_t image_index, const Timeline::Value signal_value) const {
+    constexpr uint64_t binaryValue = 0; /*ignored for binary semaphores*/
+    const array<uint64_t, 2> signalValues{binaryValue, signal_value};
+    const array<VkSemaphore, 2> signalSemaphores{renderFinishedSemaphores[currentFrame], device->timeline()->get()};
+
+    VkTimelineSemaphoreSubmitInfo timelineInfo{};
+    timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timelineInfo.waitSemaphoreValueCount = 1u;
+    timelineInfo.pWaitSemaphoreValues = &binaryValue;
+    timelineInfo.signalSemaphoreValueCount = static_cast<uint32_t>(signalValues.size());
+    timelineInfo.pSignalSemaphoreValues = signalValues.data();
+
     VkSubmitInfo submitInfo = {};
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.pNext = &timelineInfo;
 
     submitInfo.waitSemaphoreCount = 1u;
     submitInfo.pWaitSemaphores = &imageAvailableSemaphores[currentFrame];
 
     constexpr array<VkPipelineStageFlags, 1> waitStages{VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
     submitInfo.pWaitDstStageMask = waitStages.data();
-    submitInfo.commandBufferCount = 1u;
-    submitInfo.pCommandBuffers = &command_buffer;
+    //the release follows the frame in the same batch
+    const array<VkCommandBuffer, 2> commandBuffers{command_buffer, releaseBuffers.empty() ? VK_NULL_HANDLE : releaseBuffers[image_index]};
+    submitInfo.commandBufferCount = releaseBuffers.empty() ? 1u : 2u;
+    submitInfo.pCommandBuffers = commandBuffers.data();
+
+    submitInfo.signalSemaphoreCount = static_cast<uint32_t>(signalSemaphores.size());
+    submitInfo.pSignalSemaphores = signalSemaphores.data();
+
+    return vkQueueSubmit(device->graphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE);
+}
+VkResult Swapchain::acquireOwnership(const uint32_t image_index) const {
+    constexpr VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
 
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.waitSemaphoreCount = 1u;
+    submitInfo.pWaitSemaphores = &renderFinishedSemaphores[currentFrame];
+    submitInfo.pWaitDstStageMask = &waitStage;
+    submitInfo.commandBufferCount = 1u;
+    submitInfo.pCommandBuffers = &acquireBuffers[image_index];
     submitInfo.signalSemaphoreCount = 1u;
-    submitInfo.pSignalSemaphores = &renderFinishedSemaphores[currentFrame];
+    submitInfo.pSignalSemaphores = &ownershipSemaphores[currentFrame];
 
-    return vkQueueSubmit(device->graphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]);
+    return vkQueueSubmit(device->presentQueue(), 1, &submitInfo, VK_NULL_HANDLE);
 }
 VkResult Swapchain::present(const uint32_t image_index) const {
     VkPresentInfoKHR presentInfo = {};
     presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 
     presentInfo.waitSemaphoreCount = 1;
-    presentInfo.pWaitSemaphores = &renderFinishedSemaphores[currentFrame];
+    presentInfo.pWaitSemaphores = ownershipSemaphores.empty() ? &renderFinishedSemaphores[currentFrame] : &ownershipSemaphores[currentFrame];
 
     const array<VkSwapchainKHR, 1> swapchains{vkSwapchain};
 
@@ -81,20 +118,39 @@ VkResult Swapchain::present(const uint32_t image_index) const {
 }
 
 VkResult Swapchain::submitCommandBuffer(VkCommandBuffer buffer, const uint32_t image_index) {
-    if(imagesInFlight[image_index] != VK_NULL_HANDLE) vkWaitForFences(device->get(), 1, &imagesInFlight[image_index], VK_TRUE, UINT64_MAX);
-
-    imagesInFlight[image_index] = inFlightFences[currentFrame];
+    {
+        const CpuProfiler::Zone zone{"submit"};
+
+        Timeline* timeline = device->timeline();
+        {
+            //the image may still be used by an older frame than the one acquireNextImage() waited for
+            const CpuProfiler::Zone waitZone{"fence wait"};
+            timeline->wait(imageValues[image_index]);
+        }
 
-    vkResetFences(device->get(), 1, &inFlightFences[currentFrame]);
+        const Timeline::Value value = timeline->reserve();
+        const VkResult submitResult = submit(buffer, image_index, value);
+        CTH_STABLE_ERR(submitResult != VK_SUCCESS, "failed to submit draw call")
+            throw cth::except::vk_result_exception{submitResult, details->exception()}; //TEMP this is bad structure
 
+        //a failed submit never signals value, waiting on it would block forever
+        frameValues[currentFrame] = value;
+        imageValues[image_index] = value;
 
-    const VkResult submitResult = submit(buffer);
-    CTH_STABLE_ERR(submitResult != VK_SUCCESS, "failed to submit draw call")
-        throw cth::except::vk_result_exception{submitResult, details->exception()}; //TEMP this is bad structure
+        if(device->dedicatedPresent()) {
+            const VkResult acquireResult = acquireOwnership(image_index);
+            CTH_STABLE_ERR(acquireResult != VK_SUCCESS, "failed to submit present ownership acquire")
+                throw cth::except::vk_result_exception{acquireResult, details->exception()};
+        }
+    }
 
-    const auto presentResult = present(image_index);
+    VkResult presentResult;
+    {
+        const CpuProfiler::Zone zone{"present"};
+        presentResult = present(image_index);
+    }
 
-    ++currentFrame %= MAX_FRAMES_IN_FLIGHT;
+    ++currentFrame %= framesInFlight();
     return presentResult;
 }
 
@@ -110,18 +166,12 @@ VkSurfaceFormatKHR Swapchain::chooseSwapSurfaceFormat(const std::vector<VkSurfac
 
     return *it;
 }
-VkPresentModeKHR Swapchain::chooseSwapPresentMode(
-    const std::vector<VkPresentModeKHR>& available_present_modes) {
-    const auto it = ranges::find(available_present_modes, VK_PRESENT_MODE_MAILBOX_KHR);
+VkPresentModeKHR Swapchain::chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& available_present_modes) const {
+    const auto it = ranges::find_first_of(config.presentModes, available_present_modes);
 
-    if(it == available_present_modes.end()) {
-        cth::log::msg<except::INFO>("present mode: FIFO (V-Sync)");
-        return VK_PRESENT_MODE_FIFO_KHR;
-    }
-    cth::log::msg<except::INFO>("present mode: MAILBOX");
-    return VK_PRESENT_MODE_MAILBOX_KHR;
-
-    //VK_PRESENT_MODE_IMMEDIATE_KHR
+    const VkPresentModeKHR mode = it == config.presentModes.end() ? VK_PRESENT_MODE_FIFO_KHR : *it;
+    cth::log::msg<except::INFO>("present mode: {}", to_string(mode));
+    return mode;
 }
 VkExtent2D Swapchain::chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities) const {
     if(capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max()) return capabilities.currentExtent;
@@ -141,7 +191,7 @@ void Swapchain::createSwapchain() {
     const SwapchainSupportDetails swapchainSupport = device->getSwapchainSupport();
 
     const VkSurfaceFormatKHR surfaceFormat = chooseSwapSurfaceFormat(swapchainSupport.formats);
-    const VkPresentModeKHR presentMode = chooseSwapPresentMode(swapchainSupport.presentModes);
+    presentMode = chooseSwapPresentMode(swapchainSupport.presentModes);
     const VkExtent2D extent = chooseSwapExtent(swapchainSupport.capabilities);
 
     uint32_t imageCount = swapchainSupport.capabilities.minImageCount + 1;
@@ -160,18 +210,10 @@ void Swapchain::createSwapchain() {
     createInfo.imageArrayLayers = 1;
     createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
 
-    const auto [graphicsFamilyIndex, presentFamilyIndex] = device->findPhysicalQueueFamilies();
-    const array<uint32_t, 2> queueFamilyIndices{graphicsFamilyIndex, presentFamilyIndex};
-
-    if(graphicsFamilyIndex != presentFamilyIndex) {
-        createInfo.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
-        createInfo.queueFamilyIndexCount = 2;
-        createInfo.pQueueFamilyIndices = queueFamilyIndices.data();
-    } else {
-        createInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
-        createInfo.queueFamilyIndexCount = 0; // Optional
-        createInfo.pQueueFamilyIndices = nullptr; // Optional
-    }
+    //a dedicated present family transfers the ownership explicitly, see createOwnershipTransfers()
+    createInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    createInfo.queueFamilyIndexCount = 0;
+    createInfo.pQueueFamilyIndices = nullptr;
 
     createInfo.preTransform = swapchainSupport.capabilities.currentTransform;
     createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
@@ -181,7 +223,7 @@ void Swapchain::createSwapchain() {
 
     createInfo.oldSwapchain = oldSwapchain == nullptr ? VK_NULL_HANDLE : oldSwapchain->vkSwapchain;
 
-    const VkResult createResult = vkCreateSwapchainKHR(device->get(), &createInfo, nullptr, &vkSwapchain);
+    const VkResult createResult = vkCreateSwapchainKHR(device->get(), &createInfo, HostAllocator::callbacks(HostAllocator::CATEGORY_SWAPCHAIN), &vkSwapchain);
     CTH_STABLE_ERR(createResult != VK_SUCCESS, "failed to create swapchain")
         throw cth::except::vk_result_exception{createResult, details->exception()};
 
@@ -191,8 +233,11 @@ void Swapchain::createSwapchain() {
 void Swapchain::createImageViews() {
     swapchainImageViews.resize(swapchainImages.size());
 
-    for(size_t i = 0; i < swapchainImages.size(); i++)
+    for(size_t i = 0; i < swapchainImages.size(); i++) {
         swapchainImageViews[i] = createImageView(device->get(), swapchainImages[i], swapchainImageFormat);
+        if constexpr(ResourceTracker::ENABLED)
+            device->resourceTracker()->add(ResourceTracker::TYPE_IMAGE_VIEW, swapchainImageViews[i], 0, "Swapchain");
+    }
 }
 void Swapchain::setImageCount() {
     // we only specified a minimum number of images in the swap chain, so the implementation is
@@ -211,7 +256,8 @@ VkAttachmentDescription Swapchain::createColorAttachmentDescription() const {
     attachment.format = getSwapchainImageFormat();
     attachment.samples = msaaSamples;
     attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-    attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    //only the resolve attachment is stored, the msaa samples never leave tile memory
+    attachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
     attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
     attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
@@ -241,7 +287,8 @@ VkAttachmentDescription Swapchain::createColorAttachmentResolve() const {
     attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
     attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    attachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    //the ownership transfer to a dedicated present family also transitions the layout
+    attachment.finalLayout = device->dedicatedPresent() ? VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
     return attachment;
 }
@@ -288,10 +335,11 @@ void Swapchain::createRenderPass() {
     renderPassInfo.dependencyCount = 1;
     renderPassInfo.pDependencies = &subpassDependency;
 
-    const VkResult createResult = vkCreateRenderPass(device->get(), &renderPassInfo, nullptr, &renderPass);
+    const VkResult createResult = vkCreateRenderPass(device->get(), &renderPassInfo, HostAllocator::callbacks(HostAllocator::CATEGORY_SWAPCHAIN), &renderPass);
 
     CTH_STABLE_ERR(createResult != VK_SUCCESS, "failed to create render pass")
         throw cth::except::vk_result_exception{createResult, details->exception()};
+    if constexpr(ResourceTracker::ENABLED) device->resourceTracker()->add(ResourceTracker::TYPE_RENDER_PASS, renderPass, 0, "Swapchain");
 }
 
 
@@ -326,7 +374,7 @@ VkImageCreateInfo Swapchain::createDepthImageInfo(VkFormat depth_format) const {
     imageInfo.format = depth_format;
     imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
     imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+    imageInfo.usage = VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
     imageInfo.samples = msaaSamples;
     imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
     imageInfo.flags = 0;
@@ -336,43 +384,62 @@ VkImageCreateInfo Swapchain::createDepthImageInfo(VkFormat depth_format) const {
 void Swapchain::createColorResources() {
     //TODO maybe use the image class here
 
-    msaaImages.resize(imageCount());
-    msaaImageMemories.resize(imageCount());
-    msaaImageViews.resize(imageCount());
+    msaaImages.resize(framesInFlight());
+    msaaImageMemories.resize(framesInFlight());
+    msaaImageViews.resize(framesInFlight());
 
 
     const auto imageInfo = createColorImageInfo();
     for(uint32_t i = 0; i < msaaImages.size(); i++) {
         device->createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, msaaImages[i], msaaImageMemories[i]);
+        if constexpr(ResourceTracker::ENABLED)
+            device->resourceTracker()->add(ResourceTracker::TYPE_IMAGE, msaaImages[i], msaaImageMemories[i].size, "Swapchain msaa");
 
         msaaImageViews[i] = createImageView(device->get(), msaaImages[i], swapchainImageFormat);
+        if constexpr(ResourceTracker::ENABLED)
+            device->resourceTracker()->add(ResourceTracker::TYPE_IMAGE_VIEW, msaaImageViews[i], 0, "Swapchain msaa");
     }
 }
 
 void Swapchain::createDepthResources() {
     const VkFormat depthFormat = findDepthFormat();
-    swapchainImageFormat = depthFormat;
+    swapchainDepthFormat = depthFormat;
 
-    depthImages.resize(imageCount());
-    depthImageMemories.resize(imageCount());
-    depthImageViews.resize(imageCount());
+    depthImages.resize(framesInFlight());
+    depthImageMemories.resize(framesInFlight());
+    depthImageViews.resize(framesInFlight());
 
     const auto imageInfo = createDepthImageInfo(depthFormat);
 
     for(uint32_t i = 0; i < depthImages.size(); i++) {
         device->createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
             depthImages[i], depthImageMemories[i]);
+        if constexpr(ResourceTracker::ENABLED)
+            device->resourceTracker()->add(ResourceTracker::TYPE_IMAGE, depthImages[i], depthImageMemories[i].size, "Swapchain depth");
 
         depthImageViews[i] = createImageView(device->get(), depthImages[i], depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT);
+        if constexpr(ResourceTracker::ENABLED)
+            device->resourceTracker()->add(ResourceTracker::TYPE_IMAGE_VIEW, depthImageViews[i], 0, "Swapchain depth");
     }
 }
+void Swapchain::logTransientMemory() const {
+    const auto& memoryProperties = device->memoryProperties();
+    const auto lazilyAllocated = [&memoryProperties](const MemoryAllocation& memory) {
+        return static_cast<bool>(memoryProperties.memoryTypes[memory.memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT);
+    };
+
+    const bool lazy = ranges::all_of(msaaImageMemories, lazilyAllocated) && ranges::all_of(depthImageMemories, lazilyAllocated);
+    cth::log::msg<except::INFO>("transient attachments: {}", lazy ? "lazily allocated memory" : "device local memory");
+}
 
 
 void Swapchain::createFramebuffers() {
-    swapchainFramebuffers.resize(imageCount());
+    swapchainFramebuffers.resize(framesInFlight() * imageCount());
 
-    for(size_t i = 0; i < imageCount(); i++) {
-        array<VkImageView, 3> attachments = {msaaImageViews[i], depthImageViews[i], swapchainImageViews[i]};
+    for(size_t i = 0; i < swapchainFramebuffers.size(); i++) {
+        const size_t frame = i / imageCount();
+        const size_t image = i % imageCount();
+        array<VkImageView, 3> attachments = {msaaImageViews[frame], depthImageViews[frame], swapchainImageViews[image]};
 
         const VkExtent2D swapchainExtent = getSwapchainExtent();
         VkFramebufferCreateInfo framebufferInfo = {};
@@ -384,40 +451,144 @@ void Swapchain::createFramebuffers() {
         framebufferInfo.height = swapchainExtent.height;
         framebufferInfo.layers = 1;
 
-        const VkResult createResult = vkCreateFramebuffer(device->get(), &framebufferInfo, nullptr, &swapchainFramebuffers[i]);
+        const VkResult createResult = vkCreateFramebuffer(device->get(), &framebufferInfo, HostAllocator::callbacks(HostAllocator::CATEGORY_SWAPCHAIN), &swapchainFramebuffers[i]);
 
         CTH_STABLE_ERR(createResult != VK_SUCCESS, "Vk: failed to create framebuffer")
             throw cth::except::vk_result_exception{createResult, details->exception()};
+        if constexpr(ResourceTracker::ENABLED)
+            device->resourceTracker()->add(ResourceTracker::TYPE_FRAMEBUFFER, swapchainFramebuffers[i], 0, "Swapchain");
     }
 }
 
 void Swapchain::createSyncObjects() {
-    imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-    renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-    inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
-    imagesInFlight.resize(imageCount(), VK_NULL_HANDLE);
+    imageAvailableSemaphores.resize(framesInFlight());
+    renderFinishedSemaphores.resize(framesInFlight());
+    if(device->dedicatedPresent()) ownershipSemaphores.resize(framesInFlight());
+    frameValues.resize(framesInFlight(), 0);
+    imageValues.resize(imageCount(), 0);
 
     VkSemaphoreCreateInfo semaphoreInfo = {};
     semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-    VkFenceCreateInfo fenceInfo = {};
-    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-    fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-
-    for(size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-        const VkResult createWaitSemaphoreResult = vkCreateSemaphore(device->get(), &semaphoreInfo, nullptr, &imageAvailableSemaphores[i]);
-        const VkResult createSignalSemaphoreResult = vkCreateSemaphore(device->get(), &semaphoreInfo, nullptr, &renderFinishedSemaphores[i]);
-        const VkResult createFenceResult = vkCreateFence(device->get(), &fenceInfo, nullptr, &inFlightFences[i]);
+    for(size_t i = 0; i < framesInFlight(); i++) {
+        const VkResult createWaitSemaphoreResult = vkCreateSemaphore(device->get(), &semaphoreInfo, HostAllocator::callbacks(HostAllocator::CATEGORY_SWAPCHAIN), &imageAvailableSemaphores[i]);
+        const VkResult createSignalSemaphoreResult = vkCreateSemaphore(device->get(), &semaphoreInfo, HostAllocator::callbacks(HostAllocator::CATEGORY_SWAPCHAIN), &renderFinishedSemaphores[i]);
 
-        CTH_STABLE_ERR(!(createWaitSemaphoreResult == createSignalSemaphoreResult ==
-            createFenceResult == VK_SUCCESS), "Vk: failed to create synchronization objects") {
+        CTH_STABLE_ERR(createWaitSemaphoreResult != VK_SUCCESS || createSignalSemaphoreResult != VK_SUCCESS,
+            "Vk: failed to create synchronization objects") {
             if(createWaitSemaphoreResult != VK_SUCCESS) details->add("wait semaphore creation failed");
             if(createSignalSemaphoreResult != VK_SUCCESS) details->add("signal semaphore creation failed");
-            if(createFenceResult != VK_SUCCESS) details->add("fence creation failed");
 
-            throw cth::except::vk_result_exception{static_cast<VkResult>(createWaitSemaphoreResult | createSignalSemaphoreResult | createFenceResult),
+            throw cth::except::vk_result_exception{static_cast<VkResult>(createWaitSemaphoreResult | createSignalSemaphoreResult),
                 details->exception()};
         }
+        if constexpr(ResourceTracker::ENABLED) {
+            device->resourceTracker()->add(ResourceTracker::TYPE_SEMAPHORE, imageAvailableSemaphores[i], 0, "Swapchain image available");
+            device->resourceTracker()->add(ResourceTracker::TYPE_SEMAPHORE, renderFinishedSemaphores[i], 0, "Swapchain render finished");
+        }
+    }
+
+    for(auto& semaphore : ownershipSemaphores) {
+        const VkResult createResult = vkCreateSemaphore(device->get(), &semaphoreInfo, HostAllocator::callbacks(HostAllocator::CATEGORY_SWAPCHAIN), &semaphore);
+        CTH_STABLE_ERR(createResult != VK_SUCCESS, "Vk: failed to create ownership semaphore")
+            throw cth::except::vk_result_exception{createResult, details->exception()};
+        if constexpr(ResourceTracker::ENABLED) device->resourceTracker()->add(ResourceTracker::TYPE_SEMAPHORE, semaphore, 0, "Swapchain ownership");
+    }
+}
+void Swapchain::adoptSyncObjects(Swapchain& previous) {
+    imageAvailableSemaphores = std::move(previous.imageAvailableSemaphores);
+    renderFinishedSemaphores = std::move(previous.renderFinishedSemaphores);
+    ownershipSemaphores = std::move(previous.ownershipSemaphores);
+    frameValues = std::move(previous.frameValues);
+    currentFrame = previous.currentFrame;
+
+    previous.imageAvailableSemaphores.clear();
+    previous.renderFinishedSemaphores.clear();
+    previous.ownershipSemaphores.clear();
+    previous.frameValues.clear();
+
+    imageValues.resize(imageCount(), 0);
+}
+VkImageMemoryBarrier Swapchain::ownershipBarrier(const uint32_t image_index) const {
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    barrier.srcQueueFamilyIndex = device->queueFamilies().graphicsFamilyIndex;
+    barrier.dstQueueFamilyIndex = device->queueFamilies().presentFamilyIndex;
+    barrier.image = swapchainImages[image_index];
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+
+    return barrier;
+}
+void Swapchain::createOwnershipTransfers() {
+    if(!device->dedicatedPresent()) return;
+
+    //the render pass discards the previous contents, the graphics family never acquires the images back
+    releaseBuffers.resize(imageCount());
+    acquireBuffers.resize(imageCount());
+
+    //owned by the swapchain, the deletion queue destroys them with the buffers once the last frame using them finished
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.queueFamilyIndex = device->queueFamilies().graphicsFamilyIndex;
+
+    const VkResult releasePoolResult = vkCreateCommandPool(device->get(), &poolInfo, HostAllocator::callbacks(HostAllocator::CATEGORY_DEVICE),
+        &releasePool);
+    CTH_STABLE_ERR(releasePoolResult != VK_SUCCESS, "failed to create ownership release command pool")
+        throw cth::except::vk_result_exception{releasePoolResult, details->exception()};
+    if constexpr(ResourceTracker::ENABLED) device->resourceTracker()->add(ResourceTracker::TYPE_COMMAND_POOL, releasePool, 0, "Swapchain release");
+
+    poolInfo.queueFamilyIndex = device->queueFamilies().presentFamilyIndex;
+    const VkResult acquirePoolResult = vkCreateCommandPool(device->get(), &poolInfo, HostAllocator::callbacks(HostAllocator::CATEGORY_DEVICE),
+        &acquirePool);
+    CTH_STABLE_ERR(acquirePoolResult != VK_SUCCESS, "failed to create ownership acquire command pool")
+        throw cth::except::vk_result_exception{acquirePoolResult, details->exception()};
+    if constexpr(ResourceTracker::ENABLED) device->resourceTracker()->add(ResourceTracker::TYPE_COMMAND_POOL, acquirePool, 0, "Swapchain acquire");
+
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = static_cast<uint32_t>(imageCount());
+
+    allocInfo.commandPool = releasePool;
+    const VkResult releaseResult = vkAllocateCommandBuffers(device->get(), &allocInfo, releaseBuffers.data());
+    CTH_STABLE_ERR(releaseResult != VK_SUCCESS, "failed to allocate ownership release command buffers")
+        throw cth::except::vk_result_exception{releaseResult, details->exception()};
+
+    allocInfo.commandPool = acquirePool;
+    const VkResult acquireResult = vkAllocateCommandBuffers(device->get(), &allocInfo, acquireBuffers.data());
+    CTH_STABLE_ERR(acquireResult != VK_SUCCESS, "failed to allocate ownership acquire command buffers")
+        throw cth::except::vk_result_exception{acquireResult, details->exception()};
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    //the acquire of an image may still be pending on the present queue when the image is acquired again
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+
+    for(uint32_t i = 0; i < imageCount(); i++) {
+        VkImageMemoryBarrier barrier = ownershipBarrier(i);
+
+        barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        barrier.dstAccessMask = 0;
+        vkBeginCommandBuffer(releaseBuffers[i], &beginInfo);
+        vkCmdPipelineBarrier(releaseBuffers[i], VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr,
+            0, nullptr, 1, &barrier);
+        const VkResult endReleaseResult = vkEndCommandBuffer(releaseBuffers[i]);
+
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = 0;
+        vkBeginCommandBuffer(acquireBuffers[i], &beginInfo);
+        vkCmdPipelineBarrier(acquireBuffers[i], VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr,
+            0, nullptr, 1, &barrier);
+        const VkResult endAcquireResult = vkEndCommandBuffer(acquireBuffers[i]);
+
+        CTH_STABLE_ERR(endReleaseResult != VK_SUCCESS || endAcquireResult != VK_SUCCESS, "failed to record ownership transfer")
+            throw cth::except::vk_result_exception{endReleaseResult != VK_SUCCESS ? endReleaseResult : endAcquireResult, details->exception()};
     }
 }
 
@@ -431,54 +602,137 @@ void Swapchain::init() {
     createRenderPass();
     createColorResources();
     createDepthResources();
+    logTransientMemory();
 
     createFramebuffers();
-    createSyncObjects();
+    createOwnershipTransfers();
+
+    if(oldSwapchain == nullptr) createSyncObjects();
+    else adoptSyncObjects(*oldSwapchain);
 }
 
 
 
-Swapchain::Swapchain(Device* device, Window* window, const VkExtent2D window_extent) : device(device), window(window), windowExtent{window_extent} {
+Swapchain::Swapchain(Device* device, Window* window, const VkExtent2D window_extent, const SwapchainConfig& config) : device(device), window(window),
+    windowExtent{window_extent}, config{config} {
+    CTH_STABLE_ERR(config.framesInFlight == 0 || config.framesInFlight > MAX_FRAMES_IN_FLIGHT, "frames in flight out of range") {
+        details->add("frames in flight: {0}, max: {1}", config.framesInFlight, MAX_FRAMES_IN_FLIGHT);
+        throw details->exception();
+    }
+
     init();
 }
 Swapchain::Swapchain(Device* device, Window* window, const VkExtent2D window_extent, shared_ptr<Swapchain> previous) : device{device}, window(window),
-    windowExtent{window_extent}, oldSwapchain{std::move(previous)} {
+    windowExtent{window_extent}, config{previous->config}, oldSwapchain{std::move(previous)} {
     init();
     oldSwapchain = nullptr;
 }
 Swapchain::~Swapchain() {
-    ranges::for_each(swapchainImageViews, [this](VkImageView image_view) { vkDestroyImageView(device->get(), image_view, nullptr); });
-    swapchainImageViews.clear();
+    DeletionQueue* deletionQueue = device->deletionQueue();
 
-    if(vkSwapchain != nullptr) {
-        vkDestroySwapchainKHR(device->get(), vkSwapchain, nullptr);
-        vkSwapchain = nullptr;
-    }
+    ranges::for_each(swapchainFramebuffers, [deletionQueue](VkFramebuffer framebuffer) {
+        deletionQueue->enqueue(DeletionQueue::TYPE_FRAMEBUFFER, framebuffer);
+    });
+    deletionQueue->enqueue(DeletionQueue::TYPE_RENDER_PASS, renderPass);
+
+    ranges::for_each(swapchainImageViews, [deletionQueue](VkImageView image_view) {
+        deletionQueue->enqueue(DeletionQueue::TYPE_IMAGE_VIEW, image_view);
+    });
+    swapchainImageViews.clear();
 
     for(uint32_t i = 0; i < depthImages.size(); i++) {
-        vkDestroyImageView(device->get(), depthImageViews[i], nullptr);
-        vkDestroyImage(device->get(), depthImages[i], nullptr);
-        vkFreeMemory(device->get(), depthImageMemories[i], nullptr);
+        if constexpr(ResourceTracker::ENABLED) device->resourceTracker()->remove(ResourceTracker::TYPE_IMAGE, depthImages[i]);
+        deletionQueue->enqueue(DeletionQueue::TYPE_IMAGE_VIEW, depthImageViews[i]);
+        deletionQueue->enqueue(DeletionQueue::TYPE_IMAGE, depthImages[i]);
+        deletionQueue->enqueue(depthImageMemories[i]);
     }
 
     for(uint32_t i = 0; i < msaaImages.size(); i++) {
-        vkDestroyImageView(device->get(), msaaImageViews[i], nullptr);
-        vkDestroyImage(device->get(), msaaImages[i], nullptr);
-        vkFreeMemory(device->get(), msaaImageMemories[i], nullptr);
+        if constexpr(ResourceTracker::ENABLED) device->resourceTracker()->remove(ResourceTracker::TYPE_IMAGE, msaaImages[i]);
+        deletionQueue->enqueue(DeletionQueue::TYPE_IMAGE_VIEW, msaaImageViews[i]);
+        deletionQueue->enqueue(DeletionQueue::TYPE_IMAGE, msaaImages[i]);
+        deletionQueue->enqueue(msaaImageMemories[i]);
     }
 
-    ranges::for_each(swapchainFramebuffers, [this](VkFramebuffer framebuffer) { vkDestroyFramebuffer(device->get(), framebuffer, nullptr); });
+    //the presentable images belong to the swapchain, it is destroyed after the views
+    if(vkSwapchain != VK_NULL_HANDLE) {
+        deletionQueue->enqueue(DeletionQueue::TYPE_SWAPCHAIN, vkSwapchain);
+        vkSwapchain = VK_NULL_HANDLE;
+    }
 
-    vkDestroyRenderPass(device->get(), renderPass, nullptr);
+    //the acquires of the last frames may still run on the present queue, destroying the pools frees the buffers
+    if(acquirePool != VK_NULL_HANDLE) retirePresentQueue();
+    deletionQueue->enqueue(DeletionQueue::TYPE_COMMAND_POOL, releasePool);
+    deletionQueue->enqueue(DeletionQueue::TYPE_COMMAND_POOL, acquirePool);
 
-    for(size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-        vkDestroySemaphore(device->get(), renderFinishedSemaphores[i], nullptr);
-        vkDestroySemaphore(device->get(), imageAvailableSemaphores[i], nullptr);
-        vkDestroyFence(device->get(), inFlightFences[i], nullptr);
+    //empty if a successor adopted them
+    for(size_t i = 0; i < imageAvailableSemaphores.size(); i++) {
+        deletionQueue->enqueue(DeletionQueue::TYPE_SEMAPHORE, renderFinishedSemaphores[i]);
+        deletionQueue->enqueue(DeletionQueue::TYPE_SEMAPHORE, imageAvailableSemaphores[i]);
     }
+    ranges::for_each(ownershipSemaphores, [deletionQueue](VkSemaphore semaphore) {
+        deletionQueue->enqueue(DeletionQueue::TYPE_SEMAPHORE, semaphore);
+    });
 }
 
 
+void Swapchain::retirePresentQueue() const {
+    VkSemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+    VkSemaphore semaphore = VK_NULL_HANDLE;
+    VkResult result = vkCreateSemaphore(device->get(), &semaphoreInfo, HostAllocator::callbacks(HostAllocator::CATEGORY_SWAPCHAIN), &semaphore);
+    if constexpr(ResourceTracker::ENABLED)
+        if(result == VK_SUCCESS) device->resourceTracker()->add(ResourceTracker::TYPE_SEMAPHORE, semaphore, 0, "Swapchain retire");
+
+    //signaled once everything submitted to the present queue before finished
+    VkSubmitInfo presentSubmit{};
+    presentSubmit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    presentSubmit.signalSemaphoreCount = 1;
+    presentSubmit.pSignalSemaphores = &semaphore;
+    if(result == VK_SUCCESS) result = vkQueueSubmit(device->presentQueue(), 1, &presentSubmit, VK_NULL_HANDLE);
+
+    Timeline* timeline = device->timeline();
+    const Timeline::Value value = timeline->reserve();
+    const VkSemaphore timelineSemaphore = timeline->get();
+    constexpr uint64_t binaryValue = 0; /*ignored for binary semaphores*/
+    constexpr VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+    VkTimelineSemaphoreSubmitInfo timelineInfo{};
+    timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timelineInfo.waitSemaphoreValueCount = 1;
+    timelineInfo.pWaitSemaphoreValues = &binaryValue;
+    timelineInfo.signalSemaphoreValueCount = 1;
+    timelineInfo.pSignalSemaphoreValues = &value;
+
+    VkSubmitInfo graphicsSubmit{};
+    graphicsSubmit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    graphicsSubmit.pNext = &timelineInfo;
+    graphicsSubmit.signalSemaphoreCount = 1;
+    graphicsSubmit.pSignalSemaphores = &timelineSemaphore;
+    //the reserved value must be signaled, without the semaphore the submit only orders after the graphics queue
+    if(result == VK_SUCCESS) {
+        graphicsSubmit.waitSemaphoreCount = 1;
+        graphicsSubmit.pWaitSemaphores = &semaphore;
+        graphicsSubmit.pWaitDstStageMask = &waitStage;
+    } else timelineInfo.waitSemaphoreValueCount = 0;
+
+    const VkResult graphicsResult = vkQueueSubmit(device->graphicsQueue(), 1, &graphicsSubmit, VK_NULL_HANDLE);
+
+    //called from the destructor, must not throw
+    CTH_WARN(result != VK_SUCCESS || graphicsResult != VK_SUCCESS, "failed to retire the present queue, draining it") {
+        details->add("present result: {0}, graphics result: {1}", static_cast<int>(result), static_cast<int>(graphicsResult));
+        vkQueueWaitIdle(device->presentQueue());
+        vkQueueWaitIdle(device->graphicsQueue());
+        if constexpr(ResourceTracker::ENABLED)
+            if(semaphore != VK_NULL_HANDLE) device->resourceTracker()->remove(ResourceTracker::TYPE_SEMAPHORE, semaphore);
+        vkDestroySemaphore(device->get(), semaphore, HostAllocator::callbacks(HostAllocator::CATEGORY_SWAPCHAIN));
+        return;
+    }
+
+    device->deletionQueue()->enqueue(DeletionQueue::TYPE_SEMAPHORE, semaphore);
+}
+
 
 VkSampleCountFlagBits Swapchain::evaluateMsaaSampleCount() const {
     const uint32_t maxSamples = device->evaluateMaxUsableSampleCount(); //TEMP
@@ -1,4 +1,6 @@
 #pragma once
+#include "vulkan/base/CthTimeline.hpp"
+#include "vulkan/memory/allocator/CthMemoryAllocator.hpp"
 #include "vulkan/render/pass/cth_render_pass_utils.hpp"
 
 #include <vulkan/vulkan.h>
@@ -15,9 +17,18 @@ using namespace std;
 
 class Device;
 
+/**
+ * \brief runtime options of the swapchain
+ */
+struct SwapchainConfig {
+    uint32_t framesInFlight = 2; /*1 -> lowest input latency, 3 -> highest throughput*/
+    /*preference order, the first supported mode is used, falls back to FIFO which is always supported*/
+    vector<VkPresentModeKHR> presentModes{VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_FIFO_KHR};
+};
+
 class Swapchain {
 public:
-    static constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 2;
+    static constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 3; /*upper limit of SwapchainConfig::framesInFlight*/
 
     //TODO maybe move this to the image class
     static VkImageView createImageView(const VkDevice& device, VkImage image, VkFormat format,
@@ -25,9 +36,14 @@ public:
 
     [[nodiscard]] VkFormat findDepthFormat() const;
 
+    /**
+     * \brief waits on the devices timeline until the frame slot is free and acquires the next image
+     */
     [[nodiscard]] VkResult acquireNextImage(uint32_t* image_index) const;
 
     /**
+     * \brief signals the next value of the devices timeline with the frame submit
+     * \note transfers the image to the present family first if it is dedicated
      * \throws cth::except::vk_result_exception result of vkQueueSubmit()
      */
     VkResult submitCommandBuffer(VkCommandBuffer buffer, uint32_t image_index);
@@ -36,7 +52,7 @@ public:
 private:
     //createSwapchain
     [[nodiscard]] static VkSurfaceFormatKHR chooseSwapSurfaceFormat(const vector<VkSurfaceFormatKHR>& available_formats);
-    [[nodiscard]] static VkPresentModeKHR chooseSwapPresentMode(const vector<VkPresentModeKHR>& available_present_modes);
+    [[nodiscard]] VkPresentModeKHR chooseSwapPresentMode(const vector<VkPresentModeKHR>& available_present_modes) const;
     [[nodiscard]] VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities) const;
     void createSwapchain();
     //setImageCount
@@ -59,24 +75,61 @@ private:
     void createRenderPass();
     //createColorImageInfo
     [[nodiscard]] VkImageCreateInfo createColorImageInfo() const;
+    /**
+     * \brief creates one transient msaa image per frame in flight
+     */
     void createColorResources();
     //createDepthResources
     [[nodiscard]] VkImageCreateInfo createDepthImageInfo(VkFormat depth_format) const;
+    /**
+     * \brief creates one transient depth image per frame in flight
+     */
     void createDepthResources();
+    /**
+     * \brief logs if the transient attachments are backed by lazily allocated memory
+     */
+    void logTransientMemory() const;
 
     /**
+     * \brief creates a framebuffer per frame in flight and swapchain image
      * \throws cth::except::vk_result_exception result of vkCreateFramebuffer()
      */
     void createFramebuffers();
     /**
-     * \throws cth::except::vk_result_exception result of vkCreateSemaphore() / vkCreateFence()
+     * \throws cth::except::vk_result_exception result of vkCreateSemaphore()
      */
     void createSyncObjects();
+    /**
+     * \brief takes over the semaphores, frame timeline values and frame index of previous
+     * \note the semaphores may still be pending on frames in flight of previous
+     */
+    void adoptSyncObjects(Swapchain& previous);
+    /**
+     * \return queue family ownership transfer of the swapchain image from the graphics to the present family
+     */
+    [[nodiscard]] VkImageMemoryBarrier ownershipBarrier(uint32_t image_index) const;
+    /**
+     * \brief records the release on the graphics and the acquire on the present family per swapchain image
+     * \note only if the present family is dedicated, the buffers come from pools owned by the swapchain
+     * \throws cth::except::vk_result_exception result of vkCreateCommandPool()
+     * \throws cth::except::vk_result_exception result of vkAllocateCommandBuffers()
+     * \throws cth::except::vk_result_exception result of vkEndCommandBuffer()
+     */
+    void createOwnershipTransfers();
+    /**
+     * \brief makes the next graphics timeline value wait for the work submitted to the present queue so far
+     * \note the deletion queue only tracks the graphics timeline, falls back to draining the present queue on failure
+     */
+    void retirePresentQueue() const;
 
     void init();
 
     //submitCommandBuffer helpers
-    [[nodiscard]] VkResult submit(VkCommandBuffer command_buffer) const;
+    [[nodiscard]] VkResult submit(VkCommandBuffer command_buffer, uint32_t image_index, Timeline::Value signal_value) const;
+    /**
+     * \brief submits the acquire of the image on the present queue, waits for the frame submit
+     */
+    [[nodiscard]] VkResult acquireOwnership(uint32_t image_index) const;
     [[nodiscard]] VkResult present(uint32_t image_index) const;
 
 
@@ -85,40 +138,60 @@ private:
     VkFormat swapchainDepthFormat;
     VkExtent2D swapchainExtent;
 
-    vector<VkFramebuffer> swapchainFramebuffers;
+    vector<VkFramebuffer> swapchainFramebuffers; /*[frame * imageCount() + image]*/
     VkRenderPass renderPass;
 
     vector<VkImage> swapchainImages;
     vector<VkImageView> swapchainImageViews;
 
+    //transient attachments are only used by the frame in flight, not by the swapchain image
     vector<VkImage> depthImages;
     vector<VkImageView> depthImageViews;
-    vector<VkDeviceMemory> depthImageMemories;
+    vector<MemoryAllocation> depthImageMemories;
 
     vector<VkImage> msaaImages;
     vector<VkImageView> msaaImageViews;
-    vector<VkDeviceMemory> msaaImageMemories;
+    vector<MemoryAllocation> msaaImageMemories;
 
 
     Device* device;
     Window* window;
     VkExtent2D windowExtent;
+    SwapchainConfig config;
+    VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR;
 
     VkSwapchainKHR vkSwapchain;
     shared_ptr<Swapchain> oldSwapchain; //TODO why is this a shared_ptr?
 
     vector<VkSemaphore> imageAvailableSemaphores;
     vector<VkSemaphore> renderFinishedSemaphores;
-    vector<VkFence> inFlightFences;
-    vector<VkFence> imagesInFlight;
-    size_t currentFrame = 0;
+    vector<VkSemaphore> ownershipSemaphores; /*signaled by the present family acquire, empty if the present family is not dedicated*/
+    vector<Timeline::Value> frameValues; /*timeline value of the last submit per frame in flight*/
+    vector<Timeline::Value> imageValues; /*timeline value of the last submit per swapchain image*/
+    size_t currentFrame = 0; /*[0, framesInFlight())*/
+
+    //per swapchain image, empty if the present family is not dedicated
+    vector<VkCommandBuffer> releaseBuffers;
+    vector<VkCommandBuffer> acquireBuffers;
+    VkCommandPool releasePool = VK_NULL_HANDLE; /*graphics family*/
+    VkCommandPool acquirePool = VK_NULL_HANDLE; /*present family*/
 
     VkSampleCountFlagBits msaaSamples = VK_SAMPLE_COUNT_1_BIT;
     static constexpr VkSampleCountFlagBits MAX_MSAA_SAMPLES = VK_SAMPLE_COUNT_4_BIT;
 
 public:
-    Swapchain(Device* device, Window* window, VkExtent2D window_extent);
+    /**
+     * \throws cth::except::default_exception reason: frames in flight out of range
+     */
+    Swapchain(Device* device, Window* window, VkExtent2D window_extent, const SwapchainConfig& config = {});
+    /**
+     * \brief retires previous without waiting for the device, its frames in flight keep running
+     * \note the config of previous is kept
+     */
     Swapchain(Device* device, Window* window, VkExtent2D window_extent, shared_ptr<Swapchain> previous);
+    /**
+     * \note hands the swapchain, attachments, framebuffers and ownership transfer pools to the devices deletion queue
+     */
     ~Swapchain();
 
     [[nodiscard]] float extentAspectRatio() const { return static_cast<float>(swapchainExtent.width) / static_cast<float>(swapchainExtent.height); }
@@ -127,7 +200,10 @@ public:
             swapchainImageFormat;
     }
 
-    [[nodiscard]] VkFramebuffer getFrameBuffer(const uint32_t index) const { return swapchainFramebuffers[index]; }
+    /**
+     * \return framebuffer of the swapchain image with the attachments of the current frame in flight
+     */
+    [[nodiscard]] VkFramebuffer getFrameBuffer(const uint32_t index) const { return swapchainFramebuffers[currentFrame * imageCount() + index]; }
     [[nodiscard]] VkRenderPass getRenderPass() const { return renderPass; }
     [[nodiscard]] VkImageView getImageView(const uint32_t index) const { return swapchainImageViews[index]; }
     [[nodiscard]] size_t imageCount() const { return swapchainImages.size(); }
@@ -137,6 +213,13 @@ public:
     [[nodiscard]] uint32_t height() const { return swapchainExtent.height; }
     [[nodiscard]] VkImage getSwapchainImage(const int index) const { return swapchainImages[index]; }
     [[nodiscard]] VkSampleCountFlagBits getMsaaSampleCount() const { return msaaSamples; }
+    /**
+     * \return timeline value of the last submitted frame, 0 if no frame was submitted
+     */
+    [[nodiscard]] Timeline::Value lastFrameValue() const { return frameValues[(currentFrame + framesInFlight() - 1) % framesInFlight()]; }
+    [[nodiscard]] uint32_t framesInFlight() const { return config.framesInFlight; }
+    [[nodiscard]] VkPresentModeKHR getPresentMode() const { return presentMode; }
+    [[nodiscard]] const SwapchainConfig& getConfig() const { return config; }
 
 
     Swapchain(const Swapchain&) = delete;
@@ -1,6 +1,7 @@
 #include "CthWindow.hpp"
 
 #include "interface/user/HlcInputController.hpp"
+#include "vulkan/memory/allocator/CthHostAllocator.hpp"
 #include "vulkan/utility/CthVkUtils.hpp"
 #include "vulkan/base/CthInstance.hpp"
 
@@ -86,7 +87,7 @@ void Window::initWindow() {
     glfwGetWindowSize(glfwWindow, &width, &height);
 }
 void Window::createSurface() {
-    const auto result = glfwCreateWindowSurface(instance->get(), glfwWindow, nullptr, &vkSurface);
+    const auto result = glfwCreateWindowSurface(instance->get(), glfwWindow, HostAllocator::callbacks(HostAllocator::CATEGORY_INSTANCE), &vkSurface);
 
     CTH_STABLE_ERR(result != VK_SUCCESS, "failed to create GLFW window surface")
         throw cth::except::vk_result_exception{result, details->exception()};
@@ -116,6 +117,7 @@ void Window::focusCallback(const int focused) {
 }
 void Window::framebufferResizeCallback(const int new_width, const int new_height) {
     framebufferResized = true;
+    resizeTime = chrono::steady_clock::now();
     width = new_width;
     height = new_height;
 
@@ -182,7 +184,7 @@ Window::Window(Instance* instance, std::string name, const uint32_t width, const
     createSurface();
 }
 Window::~Window() {
-    vkDestroySurfaceKHR(instance->get(), vkSurface, nullptr);
+    vkDestroySurfaceKHR(instance->get(), vkSurface, HostAllocator::callbacks(HostAllocator::CATEGORY_INSTANCE));
     log::msg("destroyed surface");
 
     glfwDestroyWindow(glfwWindow);
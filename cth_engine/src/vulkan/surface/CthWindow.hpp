@@ -2,6 +2,7 @@
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
 
+#include <chrono>
 #include <string>
 #include <vector>
 
@@ -34,6 +35,7 @@ private:
 
     bool focus = true;
     bool framebufferResized = false;
+    chrono::steady_clock::time_point resizeTime{}; /*time of the last framebuffer resize event*/
 
     std::string windowName;
     int width, height;
@@ -57,6 +59,7 @@ public:
     [[nodiscard]] bool shouldClose() const { return glfwWindowShouldClose(glfwWindow); }
     [[nodiscard]] VkExtent2D getExtent() const { return {static_cast<uint32_t>(width), static_cast<uint32_t>(height)}; }
     [[nodiscard]] bool windowResized() const { return framebufferResized; }
+    [[nodiscard]] chrono::steady_clock::time_point lastResize() const { return resizeTime; }
     [[nodiscard]] GLFWwindow* window() const { return glfwWindow; }
     [[nodiscard]] bool focused() const { return focus; }
     [[nodiscard]] VkSurfaceKHR surface() const {return vkSurface; }
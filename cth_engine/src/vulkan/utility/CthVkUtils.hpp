@@ -211,6 +211,17 @@ inline std::string to_string(const VkDescriptorType type) {
         default: return "UNKNOWN_DESCRIPTOR_TYPE";
     }
 }
+inline std::string to_string(const VkPresentModeKHR mode) {
+    switch(mode) {
+        case VK_PRESENT_MODE_IMMEDIATE_KHR: return "VK_PRESENT_MODE_IMMEDIATE_KHR";
+        case VK_PRESENT_MODE_MAILBOX_KHR: return "VK_PRESENT_MODE_MAILBOX_KHR";
+        case VK_PRESENT_MODE_FIFO_KHR: return "VK_PRESENT_MODE_FIFO_KHR";
+        case VK_PRESENT_MODE_FIFO_RELAXED_KHR: return "VK_PRESENT_MODE_FIFO_RELAXED_KHR";
+        case VK_PRESENT_MODE_SHARED_DEMAND_REFRESH_KHR: return "VK_PRESENT_MODE_SHARED_DEMAND_REFRESH_KHR";
+        case VK_PRESENT_MODE_SHARED_CONTINUOUS_REFRESH_KHR: return "VK_PRESENT_MODE_SHARED_CONTINUOUS_REFRESH_KHR";
+        default: return "UNKNOWN_PRESENT_MODE";
+    }
+}
 
 [[nodiscard]] inline vector<const char*> toCharVec(const vector<string>& str_vec) {
     vector<const char*> charVec(str_vec.size());
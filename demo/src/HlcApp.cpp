@@ -22,21 +22,25 @@ void App::run() {
         const auto frameTime = chrono::duration<float, chrono::seconds::period>(chrono::high_resolution_clock::now() - frameStart).count();
         frameStart = chrono::high_resolution_clock::now();
 
-        updateFpsDisplay(frameIndex, frameTime);
+        //closed before endFrame() closes the record zone it is nested in
+        {
+            const CpuProfiler::Zone updateZone{"update"};
+            updateFpsDisplay(frameIndex, frameTime);
 
-        //inputs
-        glfwPollEvents();
-        /* if(hlcWindow->focused()) InputController::updateMousePos(hlcWindow->window());
-         else InputController::resetMouseDt(hlcWindow->window());*/
+            //inputs
+            glfwPollEvents();
+            /* if(hlcWindow->focused()) InputController::updateMousePos(hlcWindow->window());
+             else InputController::resetMouseDt(hlcWindow->window());*/
 
 
-        //camera
-        /* inputController.moveByKeys(frameTime, VIEWER);
-         inputController.rotateByMouse(frameTime, VIEWER);*/
+            //camera
+            /* inputController.moveByKeys(frameTime, VIEWER);
+             inputController.rotateByMouse(frameTime, VIEWER);*/
 
-        /*  camera.setViewYXZ(VIEWER->transform.translation, VIEWER->transform.rotation);*/
+            /*  camera.setViewYXZ(VIEWER->transform.translation, VIEWER->transform.rotation);*/
 
-        /* renderSystem.updateDynamicChunks();*/
+            /* renderSystem.updateDynamicChunks();*/
+        }
 
         FrameInfo info = {hlcRenderer->frameIndex(), 0.f, commandBuffer};
 
@@ -118,7 +122,11 @@ void App::updateFpsDisplay(const size_t frame_index, const float frame_time) con
     frameTimeSum += frame_time;
     if(frameTimeSum < 1) return;
 
-    const string x = "fps: " + std::to_string(static_cast<float>(frame_index - oldFrameIndex) / frameTimeSum);
+    GpuProfiler* profiler = hlcRenderer->gpuProfiler();
+    const auto gpuFrame = profiler->stats(profiler->scope(Renderer::GPU_FRAME_SCOPE));
+
+    const string x = "fps: " + std::to_string(static_cast<float>(frame_index - oldFrameIndex) / frameTimeSum) + ", gpu: " +
+        std::to_string(gpuFrame.avgMs) + " ms, fence wait: " + std::to_string(CpuProfiler::zoneMs("fence wait")) + " ms";
     frameTimeSum = 0;
     oldFrameIndex = frame_index;
 